@@ -1,13 +1,34 @@
 #include <cmath>
-#include <map>
 #include <math.h>
 #include <random>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 #include <array>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include "rcps.h"
 
 /* Returns an angle between 0 and 65535 inclusive by using mods. */
 int normalize(int angle) { return (((angle % 65536) + 65536) % 65536); }
@@ -49,6 +70,203 @@ template <int a, int b> int randbetween() {
   return distrib(gen);
 }
 
+/* Runtime counters, built in with make STATS=1 and compiled out otherwise, in
+which case stat_add and stat_timer_scope_t do nothing. Each thread keeps its
+own and only ever writes to them itself, so an update is a plain add, and a
+thread's counts are folded into the retired totals when it exits. --stats N
+prints the totals over every thread as one JSON line to stderr every N
+seconds.
+
+Cycles are split by what a thread is doing. A stat_timer_scope_t charges the
+cycles since the last switch to whatever the thread was doing before, then
+counts its own until it ends, so a simulation inside bookkeeping is only
+counted as simulation. */
+enum stat_counter_t {
+  count_states_evaluated,
+  count_frames_simulated,
+  count_frames_skipped, // by transposition hits and rejoining a parent
+  count_table_hits,     // pusher frames done with one transition table lookup
+  count_table_misses,   // and the ones that called rng and ran pusher_full
+  count_transposition_hits,
+  count_transposition_misses,
+  num_stat_counters
+};
+const char *stat_counter_names[num_stat_counters] = {
+    "states_evaluated", "frames_simulated",   "frames_skipped",
+    "table_hits",       "table_misses",       "transposition_hits",
+    "transposition_misses"};
+
+enum stat_timer_t {
+  time_simulating,
+  time_making_neighbours,
+  time_bookkeeping,
+  num_stat_timers,
+  time_untracked = num_stat_timers
+};
+const char *stat_timer_names[num_stat_timers] = {"simulating",
+                                                 "making_neighbours",
+                                                 "bookkeeping"};
+
+inline uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+#ifdef RCPS_STATS
+typedef struct thread_stats_t {
+  std::atomic<uint64_t> counts[num_stat_counters] = {};
+  std::atomic<uint64_t> cycles[num_stat_timers] = {};
+  int timer = time_untracked;
+  uint64_t timer_started = 0;
+  thread_stats_t *prev = nullptr;
+  thread_stats_t *next = nullptr;
+
+  thread_stats_t();
+  ~thread_stats_t();
+} thread_stats_t;
+
+// the threads that are still running, and the totals of the ones that aren't.
+// Nothing here has a destructor, so the stats line can still be printed while
+// the program exits.
+std::mutex stats_mutex;
+thread_stats_t *live_thread_stats = nullptr;
+uint64_t retired_counts[num_stat_counters];
+uint64_t retired_cycles[num_stat_timers];
+
+thread_stats_t::thread_stats_t() {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  next = live_thread_stats;
+  if (next != nullptr) {
+    next->prev = this;
+  }
+  live_thread_stats = this;
+}
+
+thread_stats_t::~thread_stats_t() {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  for (int i = 0; i < num_stat_counters; i++) {
+    retired_counts[i] += counts[i].load(std::memory_order_relaxed);
+  }
+  for (int i = 0; i < num_stat_timers; i++) {
+    retired_cycles[i] += cycles[i].load(std::memory_order_relaxed);
+  }
+  (prev != nullptr ? prev->next : live_thread_stats) = next;
+  if (next != nullptr) {
+    next->prev = prev;
+  }
+}
+
+thread_local thread_stats_t this_thread_stats;
+
+// only the owning thread writes, so this doesn't need a locked add
+inline void stat_bump(std::atomic<uint64_t> &stat, uint64_t amount) {
+  stat.store(stat.load(std::memory_order_relaxed) + amount,
+             std::memory_order_relaxed);
+}
+#endif
+
+inline void stat_add(stat_counter_t counter, uint64_t amount = 1) {
+#ifdef RCPS_STATS
+  stat_bump(this_thread_stats.counts[counter], amount);
+#else
+  (void)counter;
+  (void)amount;
+#endif
+}
+
+class stat_timer_scope_t {
+public:
+#ifdef RCPS_STATS
+  explicit stat_timer_scope_t(stat_timer_t timer)
+      : stats(this_thread_stats), outer(switch_to(timer)) {}
+  ~stat_timer_scope_t() { switch_to(outer); }
+
+private:
+  // charges the cycles so far to the current timer and starts timer
+  int switch_to(int timer) {
+    uint64_t now = read_cycles();
+    if (stats.timer != time_untracked) {
+      stat_bump(stats.cycles[stats.timer], now - stats.timer_started);
+    }
+    int was = stats.timer;
+    stats.timer = timer;
+    stats.timer_started = now;
+    return was;
+  }
+
+  thread_stats_t &stats;
+  int outer;
+#else
+  explicit stat_timer_scope_t(stat_timer_t) {}
+#endif
+};
+
+std::chrono::steady_clock::time_point stats_started;
+
+/* writes the totals over every thread as one JSON line to stderr */
+void print_stats_line() {
+#ifdef RCPS_STATS
+  uint64_t counts[num_stat_counters];
+  uint64_t cycles[num_stat_timers];
+  int threads = 0;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    std::copy(retired_counts, retired_counts + num_stat_counters, counts);
+    std::copy(retired_cycles, retired_cycles + num_stat_timers, cycles);
+    for (thread_stats_t *t = live_thread_stats; t != nullptr; t = t->next) {
+      for (int i = 0; i < num_stat_counters; i++) {
+        counts[i] += t->counts[i].load(std::memory_order_relaxed);
+      }
+      for (int i = 0; i < num_stat_timers; i++) {
+        cycles[i] += t->cycles[i].load(std::memory_order_relaxed);
+      }
+      threads++;
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - stats_started)
+                       .count();
+  auto rate = [](uint64_t hits, uint64_t misses) {
+    return hits + misses == 0 ? 0.0 : (double)hits / (hits + misses);
+  };
+  fprintf(stderr, "{\"seconds\": %.3f, \"running_threads\": %d", seconds,
+          threads);
+  for (int i = 0; i < num_stat_counters; i++) {
+    fprintf(stderr, ", \"%s\": %lu", stat_counter_names[i],
+            (unsigned long)counts[i]);
+  }
+  fprintf(stderr,
+          ", \"states_per_sec\": %.1f, \"table_hit_rate\": %.4f, "
+          "\"transposition_hit_rate\": %.4f, \"cycles\": {",
+          counts[count_states_evaluated] / seconds,
+          rate(counts[count_table_hits], counts[count_table_misses]),
+          rate(counts[count_transposition_hits],
+               counts[count_transposition_misses]));
+  for (int i = 0; i < num_stat_timers; i++) {
+    fprintf(stderr, "%s\"%s\": %lu", i == 0 ? "" : ", ", stat_timer_names[i],
+            (unsigned long)cycles[i]);
+  }
+  fprintf(stderr, "}}\n");
+#endif
+}
+
+/* prints the stats line every interval seconds until the program exits, and
+once more as it does */
+void start_stats_reporter(int interval) {
+  stats_started = std::chrono::steady_clock::now();
+  atexit(print_stats_line);
+  at_quick_exit(print_stats_line);
+  std::thread([interval] {
+    while (true) {
+      std::this_thread::sleep_for(std::chrono::seconds(interval));
+      print_stats_line();
+    }
+  }).detach();
+}
+
 /* Returns a new number that is the current number moved towards the target
 number by at most max displacement. */
 int moveNumberTowards(int currentNumber,int targetNumber,int maxDisplacement) {
@@ -114,7 +332,7 @@ constexpr std::array<unsigned short, 1U << 16> rng_function_table =
     fill_rng_function_table();
 
 /* calls and updates the rng value */
-int pollRNG(unsigned short *rngValue) {
+constexpr int pollRNG(unsigned short *rngValue) {
   // *rngValue = rng_function(*rngValue);
   // if (rng_function(*rngValue) != rng_function_table[*rngValue]) {
   //   printf("something is wrong\n");
@@ -123,6 +341,180 @@ int pollRNG(unsigned short *rngValue) {
   return (int)*rngValue;
 }
 
+/* Starting from 0 the rng walks a single cycle of 65114 values and the other
+422 values only lead into it, so a value on the cycle can be stored as its
+position on the cycle (its rng index) instead. Advancing k calls is then an add
+and a modulo, and the value at any index is a single lookup. */
+const int rng_cycle_length = 65114;
+
+// one extra entry so index rng_cycle_length wraps back to the first value,
+// which also keeps a 32 bit gather of the last entry in bounds
+constexpr std::array<unsigned short, rng_cycle_length + 1>
+fill_rng_index_to_value() {
+  std::array<unsigned short, rng_cycle_length + 1> table = {};
+  unsigned short value = 0;
+  for (int i = 0; i <= rng_cycle_length; i++) {
+    table[i] = value;
+    value = rng_function(value);
+  }
+  return table;
+}
+
+constexpr std::array<unsigned short, rng_cycle_length + 1> rng_index_to_value =
+    fill_rng_index_to_value();
+static_assert(rng_index_to_value[rng_cycle_length] == 0,
+              "rng cycle does not close after rng_cycle_length calls");
+
+// -1 for the values that are not on the cycle
+constexpr std::array<int, 1U << 16> fill_rng_value_to_index() {
+  std::array<int, 1U << 16> table = {};
+  for (unsigned int i = 0; i < (1U << 16); i++) {
+    table[i] = -1;
+  }
+  for (int i = 0; i < rng_cycle_length; i++) {
+    table[rng_index_to_value[i]] = i;
+  }
+  return table;
+}
+
+constexpr std::array<int, 1U << 16> rng_value_to_index =
+    fill_rng_value_to_index();
+
+inline int advance_rng_index(int rng_index, int calls) {
+  return (rng_index + calls) % rng_cycle_length;
+}
+
+/* the value the rng has after the given number of calls from value */
+inline unsigned short rng_value_after(unsigned short value, int calls) {
+  // values off the cycle get stepped onto it first
+  while (calls > 0 && rng_value_to_index[value] < 0) {
+    value = rng_function_table[value];
+    calls--;
+  }
+  if (calls == 0) {
+    return value;
+  }
+  return rng_index_to_value[advance_rng_index(rng_value_to_index[value],
+                                              calls)];
+}
+
+/* same as calling pollRNG the given number of times */
+int advanceRNG(unsigned short *rngValue, int calls) {
+  *rngValue = rng_value_after(*rngValue, calls);
+  return (int)*rngValue;
+}
+
+/* Everything an object function derives from the value of a single rng call,
+so each call is one lookup instead of divisions and int/double conversions.
+The formulas are kept exactly as the objects wrote them. */
+typedef struct rng_outcome_t {
+  unsigned short angular_speed;        // (rng % 7) * 200, cogs and triangle
+  unsigned short cw_direction_timer;   // (rng % 4) * 60 + 90, hands and wheels
+  unsigned char ccw_direction_timer;   // (rng % 3) * 30 + 30, hands and wheels
+  unsigned char tick_max;              // (rng % 3) * 20 + 10, hands and wheels
+  unsigned char elevator_counter;      // (rng % 6) * 30 + 30
+  unsigned char pendulum_acceleration; // 42 when rng % 3 == 0, else 13
+  unsigned char pendulum_wait;         // [5,35)
+  unsigned char pitblock_max;          // (rng % 6) * 20 + 10
+  unsigned char pusher_max_index;      // rng % 4
+  unsigned char pusher_countdown;      // [20,120)
+  unsigned char rotatingblock_time;    // (rng % 7) * 20 + 45
+  unsigned char prism_max;             // (rng % 7) * 20 + 5
+  unsigned char spinner_max;           // (rng % 4) * 30 + 30
+  unsigned char thwomp_top_max;        // [10,40)
+  unsigned char thwomp_bottom_max;     // [20,30)
+  unsigned char treadmill_max;         // (rng % 7) * 20 + 10
+  signed char sign;                    // -1 when rng <= 32766, else 1
+  unsigned char blink : 1;             // rng <= 655, bob-ombs
+  unsigned char even : 1;              // rng % 2 == 0
+  unsigned char multiple_of_4 : 1;     // rng % 4 == 0
+} rng_outcome_t;
+
+constexpr std::array<rng_outcome_t, 1U << 16> fill_rng_outcome_table() {
+  std::array<rng_outcome_t, 1U << 16> table = {};
+  for (int rng = 0; rng < (1 << 16); rng++) {
+    rng_outcome_t &o = table[rng];
+    o.angular_speed = (rng % 7) * 200;
+    o.cw_direction_timer = ((rng % 4) * 60) + 90;
+    o.ccw_direction_timer = ((rng % 3) * 30) + 30;
+    o.tick_max = ((rng % 3) * 20) + 10;
+    o.elevator_counter = ((rng % 6) * 30) + 30;
+    o.pendulum_acceleration = (rng % 3 == 0) ? 42 : 13;
+    o.pendulum_wait = (int)((rng / 65536.0 * 30) + 5);
+    o.pitblock_max = ((rng % 6) * 20) + 10;
+    o.pusher_max_index = rng % 4;
+    o.pusher_countdown = (int)((rng / 65536.0 * 100) + 20);
+    o.rotatingblock_time = ((rng % 7) * 20) + 45;
+    o.prism_max = ((rng % 7) * 20) + 5;
+    o.spinner_max = ((rng % 4) * 30) + 30;
+    o.thwomp_top_max = (int)((rng / 65536.0 * 30) + 10);
+    o.thwomp_bottom_max = (int)(rng / 65536.0 * 10 + 20);
+    o.treadmill_max = ((rng % 7) * 20) + 10;
+    o.sign = (rng <= 32766) ? -1 : 1;
+    o.blink = rng <= 655;
+    o.even = rng % 2 == 0;
+    o.multiple_of_4 = rng % 4 == 0;
+  }
+  return table;
+}
+
+constexpr std::array<rng_outcome_t, 1U << 16> rng_outcome_table =
+    fill_rng_outcome_table();
+
+/* calls and updates the rng value, returning what the objects derive from it */
+constexpr const rng_outcome_t &pollRNG_outcome(unsigned short *rngValue) {
+  return rng_outcome_table[pollRNG(rngValue)];
+}
+
+/* Transition tables. A table holds, for every state of an object, what its next
+frame is when no rng is called, found by running the object's full function on
+each state at compile time and seeing whether the rng moved. A codec numbers the
+states below codec::size and marks the entries of frames that call rng, which
+still run the full function.
+
+This only pays off for objects with branchy frames, which is just the pusher.
+For the objects that count a single timer the dependent load costs more than
+the well predicted branches it replaces, and the pendulums, pit block, hands,
+wheels and thwomp carry positions and angles, so they have far too many states
+for a table. */
+template <typename codec,
+          void (*full)(typename codec::object_t *, unsigned short *)>
+constexpr std::array<typename codec::object_t, codec::size>
+fill_transition_table() {
+  std::array<typename codec::object_t, codec::size> table = {};
+  for (size_t code = 0; code < codec::size; code++) {
+    typename codec::object_t object = codec::state(code);
+    unsigned short rng = 0; // any rng call moves it off 0
+    full(&object, &rng);
+    if (rng != 0) {
+      codec::mark_calls_rng(&object);
+    }
+    table[code] = object;
+  }
+  return table;
+}
+
+template <typename codec,
+          void (*full)(typename codec::object_t *, unsigned short *)>
+constexpr std::array<typename codec::object_t, codec::size> transition_table =
+    fill_transition_table<codec, full>();
+
+/* moves an object forward one frame with a single lookup unless it calls rng */
+template <typename codec,
+          void (*full)(typename codec::object_t *, unsigned short *)>
+inline void quick_step(typename codec::object_t *object,
+                       unsigned short *rngValue) {
+  const typename codec::object_t &quick_check =
+      transition_table<codec, full>[codec::code(*object)];
+  if (!codec::calls_rng(quick_check)) {
+    stat_add(count_table_hits);
+    *object = quick_check;
+    return;
+  }
+  stat_add(count_table_misses);
+  full(object, rngValue);
+}
+
 /* A bob-omb is the black bomb enemy. There are two of them in TTC,
 near the start of the course. A bob-omb calls RNG every frame to determine
 whether it should blink its eyes. If it does blink, then it blinks
@@ -136,7 +528,7 @@ still update and call RNG just as normal. */
 typedef struct bobomb_t {
   // how deep into the blink the bob-omb is
   // this variable is 0 when the bob-omb is not blinking
-  int blinkingTimer;
+  uint8_t blinkingTimer;
 } bobomb_t;
 
 void bobomb(bobomb_t *b, unsigned short *rngValue) {
@@ -144,7 +536,7 @@ void bobomb(bobomb_t *b, unsigned short *rngValue) {
   // this variable is 0 when the bob-omb is not blinking
   if (b->blinkingTimer > 0) { // currently blinking
     b->blinkingTimer = (b->blinkingTimer + 1) % 16;
-  } else if (pollRNG(rngValue) <= 655) { // not currently blinking
+  } else if (pollRNG_outcome(rngValue).blink) { // not currently blinking
     b->blinkingTimer++;
   }
 }
@@ -157,12 +549,19 @@ by the current angular velocity. When the current angular velocity reaches
 the target angular velocity, a new target angular velocity is calculated. */
 
 typedef struct cog_t {
-  int currentAngularVelocity; // = -1200, -1150, ... , 1150, 1200
-  int targetAngularVelocity;  // = -1200, -1000, ... , 1000, 1200
-  int last_target = 0;
-  int small_enough_movement_so_far = true;
+  int16_t currentAngularVelocity; // = -1200, -1150, ... , 1150, 1200
+  int16_t targetAngularVelocity;  // = -1200, -1000, ... , 1000, 1200
 } cog_t;
 
+/* the cog under rcps also remembers its last target, for the check that it
+only ever turns back and forth by small amounts */
+typedef struct rcpscog_t {
+  int16_t currentAngularVelocity;
+  int16_t targetAngularVelocity;
+  int16_t last_target = 0;
+  int8_t small_enough_movement_so_far = true;
+} rcpscog_t;
+
 void cog(cog_t *c, unsigned short *rngValue) {
   if (c->currentAngularVelocity > c->targetAngularVelocity) {
     c->currentAngularVelocity -= 50;
@@ -171,14 +570,14 @@ void cog(cog_t *c, unsigned short *rngValue) {
   }
   if (c->currentAngularVelocity == c->targetAngularVelocity) {
     int magnitude =
-        (pollRNG(rngValue) % 7) * 200; // = 0, 200, 400, 600, 800, 1000, 1200
-    int sign = (pollRNG(rngValue) <= 32766) ? -1 : 1; // = -1, 1
+        pollRNG_outcome(rngValue).angular_speed; // = 0, 200, ... , 1200
+    int sign = pollRNG_outcome(rngValue).sign; // = -1, 1
     c->targetAngularVelocity =
         magnitude * sign; // = -1200, -1000, ... , 1000, 1200
   }
 }
 
-void rcpscog(cog_t *c, unsigned short *rngValue) {
+void rcpscog(rcpscog_t *c, unsigned short *rngValue) {
   if (c->currentAngularVelocity > c->targetAngularVelocity) {
     c->currentAngularVelocity -= 50;
   } else if (c->currentAngularVelocity < c->targetAngularVelocity) {
@@ -186,13 +585,13 @@ void rcpscog(cog_t *c, unsigned short *rngValue) {
   }
   if (c->currentAngularVelocity == c->targetAngularVelocity) {
     int magnitude =
-        (pollRNG(rngValue) % 7) * 200; // = 0, 200, 400, 600, 800, 1000, 1200
+        pollRNG_outcome(rngValue).angular_speed; // = 0, 200, ... , 1200
     if (magnitude > 200) {
       c->small_enough_movement_so_far = 0;
       c->last_target = 0;
       return;
     }
-    int sign = (pollRNG(rngValue) <= 32766) ? -1 : 1; // = -1, 1
+    int sign = pollRNG_outcome(rngValue).sign; // = -1, 1
     c->last_target = c->targetAngularVelocity;
     c->targetAngularVelocity =
         magnitude * sign; // = -1200, -1000, ... , 1000, 1200
@@ -214,7 +613,7 @@ until the next possible direction switch. */
 typedef struct elevator_t {
   // int max; // = 30, 60, 90, 120, 150, 180
   // starts at 30, 60, 90, 120, 150, 180 and goes down to 0
-  int counter;
+  uint8_t counter;
 
 } elevator_t;
 
@@ -230,8 +629,8 @@ typedef struct elevator_t {
 void elevator(elevator_t *e, unsigned short *rngValue) {
   if (e->counter == 0) {
     pollRNG(rngValue); // direction call
-    e->counter =
-        ((pollRNG(rngValue) % 6) * 30) + 30; // = 30, 60, 90, 120, 150, 180
+    e->counter = pollRNG_outcome(rngValue)
+                     .elevator_counter; // = 30, 60, 90, 120, 150, 180
   }
   e->counter--;
 }
@@ -247,12 +646,13 @@ it has the chance to change direction again (i.e. what value its direction
 timer will be). */
 
 typedef struct hand_t {
-  int angle;
-  int max;
-  int targetAngle;
-  int displacement;
-  int directionTimer;
-  int timer;
+  // angles stay ints, a random state can start them below 0
+  int32_t angle;
+  int32_t targetAngle;
+  int16_t max;
+  int16_t displacement;
+  int16_t directionTimer;
+  int16_t timer;
 } hand_t;
 
 void hand(hand_t *h, unsigned short *rngValue) {
@@ -267,16 +667,17 @@ void hand(hand_t *h, unsigned short *rngValue) {
     h->targetAngle = h->targetAngle + h->displacement;
     h->targetAngle = normalize(h->targetAngle);
     if (h->directionTimer == 0) { // time to maybe switch directions
-      if (pollRNG(rngValue) % 4 == 0) {
+      if (pollRNG_outcome(rngValue).multiple_of_4) {
         h->displacement = 1092;
-        h->directionTimer = ((pollRNG(rngValue) % 3) * 30) + 30; // = 30, 60, 90
+        h->directionTimer =
+            pollRNG_outcome(rngValue).ccw_direction_timer; // = 30, 60, 90
       } else {
         h->displacement = -1092;
-        h->directionTimer =
-            ((pollRNG(rngValue) % 4) * 60) + 90; // = 90, 150, 210, 270
+        h->directionTimer = pollRNG_outcome(rngValue)
+                                .cw_direction_timer; // = 90, 150, 210, 270
       }
     }
-    h->max = ((pollRNG(rngValue) % 3) * 20) + 10; // = 10, 30, 50
+    h->max = pollRNG_outcome(rngValue).tick_max; // = 10, 30, 50
     h->timer = 0;
   }
   h->timer++;
@@ -290,11 +691,11 @@ with that acceleration. Once it crosses strictly past the vertical (i.e. angle
 the pendulum decelerates by that same acceleration until it comes to a stop. */
 
 typedef struct pendulum_t {
-  int accelerationDirection;
-  int angle;
-  int angularVelocity;
-  int accelerationMagnitude;
-  int waitingTimer;
+  int8_t accelerationDirection;
+  int8_t accelerationMagnitude;
+  int16_t angle;
+  int16_t angularVelocity;
+  int16_t waitingTimer;
 } pendulum_t;
 
 void pendulum(pendulum_t *p, unsigned short *rngValue) {
@@ -314,10 +715,9 @@ void pendulum(pendulum_t *p, unsigned short *rngValue) {
     p->angle = p->angle + p->angularVelocity;
     if (p->angularVelocity == 0) { // reached peak of swing
       p->accelerationMagnitude =
-          (pollRNG(rngValue) % 3 == 0) ? 42 : 13; // = 13, 42
-      if (pollRNG(rngValue) % 2 == 0) {           // stop for some time
-        p->waitingTimer =
-            (int)((pollRNG(rngValue) / 65536.0 * 30) + 5); // = [5,35)
+          pollRNG_outcome(rngValue).pendulum_acceleration; // = 13, 42
+      if (pollRNG_outcome(rngValue).even) {                // stop for some time
+        p->waitingTimer = pollRNG_outcome(rngValue).pendulum_wait; // = [5,35)
       }
     }
   }
@@ -330,11 +730,11 @@ determine how long it should wait for. It does not do this at the bottom,
 since the time it waits there is always 20 frames. */
 
 typedef struct pitblock_t {
-  int height;
-  int verticalSpeed;
-  int state; // 0 = going up, 1 = going down
-  int max;
-  int counter;
+  int16_t height;
+  int8_t verticalSpeed;
+  uint8_t state; // 0 = going up, 1 = going down
+  uint8_t max;
+  uint8_t counter;
 } pitblock_t;
 
 void pitblock(pitblock_t *p, unsigned short *rngValue) {
@@ -345,8 +745,8 @@ void pitblock(pitblock_t *p, unsigned short *rngValue) {
         p->verticalSpeed = -9;
         p->state = 1;
         p->counter = 0;
-        p->max =
-            ((pollRNG(rngValue) % 6) * 20) + 10; // = 10, 30, 50, 70, 90, 110
+        p->max = pollRNG_outcome(rngValue)
+                     .pitblock_max; // = 10, 30, 50, 70, 90, 110
       }
     } else { // move down
       p->height = std::max(-71, p->height + p->verticalSpeed);
@@ -381,73 +781,7 @@ typedef struct pusher_t {
   uint8_t counter;
 } pusher_t;
 
-// returns what it should be at the end if there was no rng calls, else sets max
-// to 0
-constexpr pusher_t pusher_precalc(pusher_t p) {
-  if (p.state == 0) { // flush with wall
-    if (p.counter <= max_index_to_max[p.max_index]) {
-      p.counter++;
-    } else if (p.countdown > 0) {
-      p.countdown--;
-      p.counter++;
-    } else {
-      p.max_index = 255;
-    }
-  } else if (p.state == 1) { // retracted
-    if (p.counter < 10) {    // waiting
-      p.counter++;
-    } else {
-      if (p.countdown > 0) { // moving back in
-        p.countdown--;
-        p.counter++;
-      } else { // moving back in
-        p.state = 2;
-        p.counter = 0;
-      }
-    }
-  } else if (p.state == 2) { // extending
-    if (p.counter == 0) {    // wait one frame
-      p.counter++;
-    } else if (p.counter == 1) { // either extend out or fake it
-      p.max_index = 255;
-    } else if (p.counter < 36) { // continue extending out
-      p.counter++;
-    } else { // finished extending out
-      p.state = 3;
-      p.counter = 0;
-    }
-  } else {                // retracting
-    if (p.counter < 82) { // still retracting
-      p.counter++;
-    } else { // finished retracting
-      p.state = 0;
-      p.counter = 0;
-    }
-  }
-  return p;
-}
-constexpr std::array<std::array<std::array<std::array<pusher_t, 220>, 4>, 120>,
-                     4>
-precalc_pusher_table() {
-  std::array<std::array<std::array<std::array<pusher_t, 220>, 4>, 120>, 4>
-      table = {};
-  for (uint8_t max_index = 0; max_index < 4; max_index++) {
-    for (uint8_t countdown = 0; countdown < 120; countdown++) {
-      for (uint8_t state = 0; state < 4; state++) {
-        for (uint8_t counter = 0; counter < 220; counter++) {
-          pusher_t pusher = {max_index, countdown, state, counter};
-          table[max_index][countdown][state][counter] = pusher_precalc(pusher);
-        }
-      }
-    }
-  }
-
-  return table;
-}
-
-constexpr auto pusher_precalc_table = precalc_pusher_table();
-
-void pusher_full(pusher_t *p, unsigned short *rngValue) {
+constexpr void pusher_full(pusher_t *p, unsigned short *rngValue) {
   if (p->state == 0) { // flush with wall
     if (p->counter <= max_index_to_max[p->max_index]) {
       p->counter++;
@@ -455,11 +789,10 @@ void pusher_full(pusher_t *p, unsigned short *rngValue) {
       p->countdown--;
       p->counter++;
     } else {
-      p->max_index = pollRNG(rngValue) % 4;
+      p->max_index = pollRNG_outcome(rngValue).pusher_max_index;
       // countdown = 0 or [20,120)
-      if (pollRNG(rngValue) % 2 == 0) {
-        p->countdown =
-            (int)((pollRNG(rngValue) / 65536.0 * 100) + 20); // = [20,120)
+      if (pollRNG_outcome(rngValue).even) {
+        p->countdown = pollRNG_outcome(rngValue).pusher_countdown; // = [20,120)
       }
       p->state = 1;
       p->counter = 0;
@@ -480,7 +813,7 @@ void pusher_full(pusher_t *p, unsigned short *rngValue) {
     if (p->counter == 0) {    // wait one frame
       p->counter++;
     } else if (p->counter == 1) {       // either extend out or fake it
-      if (pollRNG(rngValue) % 4 == 0) { // fake extend
+      if (pollRNG_outcome(rngValue).multiple_of_4) { // fake extend
         p->state = 0;
         p->counter = 0;
       } else { // actually extend
@@ -502,28 +835,30 @@ void pusher_full(pusher_t *p, unsigned short *rngValue) {
   }
 }
 
-void pusher(pusher_t *p, unsigned short *rngValue) {
-  pusher_t quick_check =
-      pusher_precalc_table[p->max_index][p->countdown][p->state][p->counter];
-  if (quick_check.max_index != 255) {
-    *p = quick_check;
-    return;
+// a flush pusher can count up to max (100) + 1 + countdown (119) = 220
+typedef struct pusher_codec_t {
+  typedef pusher_t object_t;
+  static constexpr size_t size = 4 * 120 * 4 * 221;
+  static constexpr size_t code(const pusher_t &p) {
+    return (((size_t)p.max_index * 120 + p.countdown) * 4 + p.state) * 221 +
+           p.counter;
   }
-  // pusher_t starting_state = *p;
-  pusher_full(p, rngValue);
-
-  // if (quick_check.max != 0) {
-  //   if (quick_check.max != p->max || quick_check.countdown != p->countdown ||
-  //       quick_check.state != p->state || quick_check.counter != p->counter) {
-  //     printf("got {%d, %d, %d, %d}, expected {%d, %d, %d, %d}\n",
-  //            quick_check.max, quick_check.countdown, quick_check.state,
-  //            quick_check.counter, p->max, p->countdown, p->state,
-  //            p->counter);
-  //     printf("starting state = {%d, %d, %d, %d}\n", starting_state.max,
-  //            starting_state.countdown, starting_state.state,
-  //            starting_state.counter);
-  //   }
-  // }
+  static constexpr pusher_t state(size_t code) {
+    pusher_t p = {};
+    p.counter = code % 221;
+    p.state = code / 221 % 4;
+    p.countdown = code / (221 * 4) % 120;
+    p.max_index = code / (221 * 4 * 120);
+    return p;
+  }
+  static constexpr void mark_calls_rng(pusher_t *p) { p->max_index = 255; }
+  static constexpr bool calls_rng(const pusher_t &p) {
+    return p.max_index == 255;
+  }
+} pusher_codec_t;
+
+void pusher(pusher_t *p, unsigned short *rngValue) {
+  quick_step<pusher_codec_t, pusher_full>(p, rngValue);
 }
 
 /* Rotating block is the cube that rotates around a horizontal axis
@@ -546,13 +881,13 @@ this long, it begins rotating and the process repeats. */
 // }
 
 typedef struct rotatingblock_t {
-  int remaining_time; // 45, 65, 85, 105, 125, 145, 165 then counts down to 0
+  uint8_t remaining_time; // 45, 65, 85, 105, 125, 145, 165 then counts down to 0
 } rotatingblock_t;
 
 void rotatingblock(rotatingblock_t *rb, unsigned short *rngValue) {
   if (rb->remaining_time == 0) { // done waiting
-    rb->remaining_time =
-        ((pollRNG(rngValue) % 7) * 20) + 45; // = 5, 25, 45, 65, 85, 105, 125
+    rb->remaining_time = pollRNG_outcome(rngValue)
+                             .rotatingblock_time; // = 45, 65, 85, ... , 165
   }
   rb->remaining_time--;
 }
@@ -564,15 +899,15 @@ long it should wait until the next rotation. Once it has waited this long, it
 begins rotating and the process repeats. */
 
 typedef struct rotatingtriangularprism_t {
-  int max;   // = 5, 25, 45, 65, 85, 105, 125
-  int timer; // [0,170]
+  uint8_t max;   // = 5, 25, 45, 65, 85, 105, 125
+  uint8_t timer; // [0,170]
 } rotatingtriangularprism_t;
 
 void rotatingtriangularprism(rotatingtriangularprism_t *rtp,
                              unsigned short *rngValue) {
   if (rtp->timer >= rtp->max + 45) { // done waiting
     rtp->max =
-        ((pollRNG(rngValue) % 7) * 20) + 5; // = 5, 25, 45, 65, 85, 105, 125
+        pollRNG_outcome(rngValue).prism_max; // = 5, 25, 45, 65, 85, 105, 125
     rtp->timer = 0;
   }
   rtp->timer++;
@@ -587,16 +922,16 @@ intended direction. Then for 1 frame, the spinner spins counterclockwise. */
 
 typedef struct spinner_t {
   // int direction; // 1 = CCW, -1 = CW
-  int max;
-  int counter;
+  uint8_t max;
+  uint8_t counter;
 } spinner_t;
 
 void spinner(spinner_t *sp, unsigned short *rngValue) {
   if (sp->counter > sp->max) {
     // calculate new spin
     // sp->direction = (pollRNG(rngValue) <= 32766) ? -1 : 1; // = -1, 1
-    pollRNG(rngValue);                             // for direction
-    sp->max = ((pollRNG(rngValue) % 4) * 30) + 30; // = 30, 60, 90, 120
+    pollRNG(rngValue);                               // for direction
+    sp->max = pollRNG_outcome(rngValue).spinner_max; // = 30, 60, 90, 120
     sp->counter = 0;
   }
   sp->counter++;
@@ -606,8 +941,8 @@ void spinner(spinner_t *sp, unsigned short *rngValue) {
 (i.e. changes its yaw). It functions exactly as the cog does. */
 
 typedef struct spinningtriangle_t {
-  int currentAngularVelocity; // = -1200, -1150, ... , 1150, 1200
-  int targetAngularVelocity;  // = -1200, -1000, ... , 1000, 1200
+  int16_t currentAngularVelocity; // = -1200, -1150, ... , 1150, 1200
+  int16_t targetAngularVelocity;  // = -1200, -1000, ... , 1000, 1200
 } spinningtriangle_t;
 
 void spinningtriangle(spinningtriangle_t *st, unsigned short *rngValue) {
@@ -618,8 +953,8 @@ void spinningtriangle(spinningtriangle_t *st, unsigned short *rngValue) {
   }
   if (st->currentAngularVelocity == st->targetAngularVelocity) {
     int magnitude =
-        (pollRNG(rngValue) % 7) * 200; // = 0, 200, 400, 600, 800, 1000, 1200
-    int sign = (pollRNG(rngValue) <= 32766) ? -1 : 1; // = -1, 1
+        pollRNG_outcome(rngValue).angular_speed; // = 0, 200, ... , 1200
+    int sign = pollRNG_outcome(rngValue).sign; // = -1, 1
     st->targetAngularVelocity =
         magnitude * sign; // = -1200, -1000, ... , 1000, 1200
   }
@@ -632,11 +967,11 @@ It calls RNG when it reaches the top to determine how long it should wait for,
 and it also does this at the bottom. */
 
 typedef struct thwomp_t {
-  int height;
-  int verticalSpeed;
-  int max;   // [10,40) or [20,30)
-  int state; // 0 = going up, 1 = at top, 2 = going down, 3/4 = at bottom
-  int counter;
+  int16_t height;
+  int16_t verticalSpeed;
+  uint8_t max;   // [10,40) or [20,30)
+  uint8_t state; // 0 = going up, 1 = at top, 2 = going down, 3/4 = at bottom
+  uint8_t counter;
 } thwomp_t;
 
 void thwomp(thwomp_t *th, unsigned short *rngValue) {
@@ -649,7 +984,7 @@ void thwomp(thwomp_t *th, unsigned short *rngValue) {
     }
   } else if (th->state == 1) { // at top
     if (th->counter == 0) {    // just reached top
-      th->max = (int)((pollRNG(rngValue) / 65536.0 * 30) + 10); // = [10,40)
+      th->max = pollRNG_outcome(rngValue).thwomp_top_max; // = [10,40)
     }
     if (th->counter <= th->max) { // waiting
       th->counter++;
@@ -675,7 +1010,7 @@ void thwomp(thwomp_t *th, unsigned short *rngValue) {
     }
   } else {                  // at bottom (2/2)
     if (th->counter == 0) { // just reached bottom
-      th->max = (int)(pollRNG(rngValue) / 65536.0 * 10 + 20); // = [20,30)
+      th->max = pollRNG_outcome(rngValue).thwomp_bottom_max; // = [20,30)
     }
     if (th->counter <= th->max) { // waiting
       th->counter++;
@@ -696,10 +1031,10 @@ in that direction for the allotted time, it decelerates to a stop, and the
 process repeats. */
 
 typedef struct treadmill_t {
-  int currentSpeed;
-  int targetSpeed;
-  int max;
-  int counter;
+  int8_t currentSpeed;
+  int8_t targetSpeed;
+  uint8_t max;
+  uint8_t counter;
 } treadmill_t;
 
 void treadmill(treadmill_t *tr, unsigned short *rngValue) {
@@ -711,9 +1046,9 @@ void treadmill(treadmill_t *tr, unsigned short *rngValue) {
   } else { // slow down
     tr->currentSpeed = moveNumberTowards(tr->currentSpeed, 0, 10);
     if (tr->currentSpeed == 0) { // came to a stop
-      tr->max =
-          ((pollRNG(rngValue) % 7) * 20) + 10; // = 10, 30, 50, 70, 90, 110, 130
-      tr->targetSpeed = (pollRNG(rngValue) <= 32766) ? -50 : 50; // = -50, 50
+      tr->max = pollRNG_outcome(rngValue)
+                    .treadmill_max; // = 10, 30, 50, 70, 90, 110, 130
+      tr->targetSpeed = pollRNG_outcome(rngValue).sign * 50; // = -50, 50
       tr->counter = 0;
     }
   }
@@ -725,12 +1060,12 @@ floor in various parts of TTC. They appear in pairs. They function exactly as
 the hands do, except that their ticks are greater in magnitude. */
 
 typedef struct wheel_t {
-  int angle;
-  int max; // = 10, 30, 50
-  int targetAngle;
-  int displacement;
-  int directionTimer; // = 30, 60, 90 or = 90, 150, 210, 270
-  int timer;
+  int32_t angle;
+  int32_t targetAngle;
+  int16_t max; // = 10, 30, 50
+  int16_t displacement;
+  int16_t directionTimer; // = 30, 60, 90 or = 90, 150, 210, 270
+  int16_t timer;
 } wheel_t;
 
 void wheel(wheel_t *w, unsigned short *rngValue) {
@@ -746,16 +1081,17 @@ void wheel(wheel_t *w, unsigned short *rngValue) {
     w->targetAngle = w->targetAngle + w->displacement;
     w->targetAngle = normalize(w->targetAngle);
     if (w->directionTimer == 0) {       // time to maybe switch directions
-      if (pollRNG(rngValue) % 4 == 0) { // time to move CCW
+      if (pollRNG_outcome(rngValue).multiple_of_4) { // time to move CCW
         w->displacement = 3276;
-        w->directionTimer = ((pollRNG(rngValue) % 3) * 30) + 30; // = 30, 60, 90
+        w->directionTimer =
+            pollRNG_outcome(rngValue).ccw_direction_timer; // = 30, 60, 90
       } else { // time to move CW
         w->displacement = -3276;
-        w->directionTimer =
-            (pollRNG(rngValue) % 4) * 60 + 90; // = 90, 150, 210, 270
+        w->directionTimer = pollRNG_outcome(rngValue)
+                                .cw_direction_timer; // = 90, 150, 210, 270
       }
     }
-    w->max = ((pollRNG(rngValue) % 3) * 20) + 10; // = 10, 30, 50
+    w->max = pollRNG_outcome(rngValue).tick_max; // = 10, 30, 50
     w->timer = 0;
     w->timer++;
   } else { // timer high enough, but not at target angle (will only happen at
@@ -764,854 +1100,5629 @@ void wheel(wheel_t *w, unsigned short *rngValue) {
   }
 }
 
+/* Every field is as narrow as its values allow so a whole state is five cache
+lines, which every copy, checkpoint and comparison of a state pays for. The
+objects are in advanceobjects order, so the ones that keep moving after rcpscog
+freezes the rest share the first two lines. */
 // got initial state from pannen, update if nessesary
-using objects_t = struct objects_t {
+using objects_t = struct alignas(64) objects_t {
   rotatingblock_t rotating_blocks[6] = {{40 + 125 - 31}, {40 + 5 - 16},
                                         {40 + 25 - 6},   {40 + 45 - 51},
                                         {40 + 65 - 71},  {40 + 25 - 61}};
   rotatingtriangularprism_t rotatingtriangularprisms[2] = {{125, 126},
                                                            {125, 26}};
-  pendulum_t pendulums[4] = {{1, -7155, 26, 13, 0},
-                             {1, -1993, 390, 13, 0},
-                             {-1, 5822, 130, 13, 0},
-                             {1, -9159, 84, 42, 0}};
+  pendulum_t pendulums[4] = {{1, 13, -7155, 26, 0},
+                             {1, 13, -1993, 390, 0},
+                             {-1, 13, 5822, 130, 0},
+                             {1, 42, -9159, 84, 0}};
   treadmill_t treadmill = {0, -50, 30, 5};
   pusher_t pushers[12] = {{3, 40, 1, 39}, {2, 0, 3, 82}, {1, 49, 1, 42},
                           {2, 0, 3, 21},  {3, 0, 3, 5},  {0, 0, 2, 7},
                           {3, 0, 0, 87},  {2, 0, 3, 5},  {2, 0, 0, 51},
                           {0, 0, 3, 80},  {0, 0, 3, 63}, {1, 0, 3, 6}};
-  cog_t rcpscog = {150, -200};
+  rcpscog_t rcpscog = {150, -200};
   cog_t cogs[4] = {{600, 800}, {-350, -600}, {-300, 1200}, {900, 1000}};
   spinningtriangle_t spinningtriangles[2] = {{150, 0}, {-950, -1000}};
   pitblock_t pitblock = {259, -9, 1, 110, 110};
-  hand_t hands[2] = {{33704, 50, 33704, -1092, 173, 36},
-                     {5344, 50, 5344, -1092, 168, 32}};
+  hand_t hands[2] = {{33704, 33704, 50, -1092, 173, 36},
+                     {5344, 5344, 50, -1092, 168, 32}};
   spinner_t spinners[14] = {{30, 14},  {30, 24}, {30, 26}, {120, 116}, {90, 72},
                             {120, 6},  {90, 81}, {60, 41}, {120, 115}, {90, 61},
                             {120, 13}, {90, 65}, {60, 31}, {120, 37}};
   wheel_t wheels[6] = {
-      {42016, 50, 42016, 3276, 0, 42},   {12580, 50, 12580, -3276, 81, 45},
-      {35416, 50, 35416, -3276, 97, 32}, {48616, 50, 48616, 3276, 49, 42},
-      {58744, 30, 58268, -3276, 23, 15}, {40704, 30, 38628, -3276, 84, 7}};
+      {42016, 42016, 50, 3276, 0, 42},   {12580, 12580, 50, -3276, 81, 45},
+      {35416, 35416, 50, -3276, 97, 32}, {48616, 48616, 50, 3276, 49, 42},
+      {58744, 58268, 30, -3276, 23, 15}, {40704, 38628, 30, -3276, 84, 7}};
   elevator_t elevators[2] = {{180 - 120}, {150 - 106}};
   cog_t sixthcog = {50, -800};
   thwomp_t thwomp = {6482, 0, 23, 0, 29};
   bobomb_t bobombs[2] = {{0}, {0}};
   unsigned short rngValue = 43517;
 };
+static_assert(sizeof(objects_t) == 5 * 64, "objects_t should be 5 cache lines");
+
+// the state every dust vector starts from, the one above unless --state loads
+// a STROOP file
+objects_t initial_state;
+
+/* Loading STROOP's TtcState files (like state.txt) straight into objects_t. The
+file is mapped and scanned once, in place: every tag's attributes are read as
+numbers as the scanner passes them, and the tag is handed to the reader for its
+kind of object, which fills in the next one of them. The objects come in the
+same order as in objects_t, and the TtcCogs are rcpscog, then the four cogs,
+then the sixth cog. Tags for things objects_t doesn't have (amps, dust and the
+treadmills other than the first) are skipped. */
+const int max_stroop_attributes = 8;
+
+/* one tag of a STROOP file, pointing into the mapped file */
+typedef struct stroop_tag_t {
+  const char *name;
+  size_t name_length;
+  int num_attributes;
+  const char *attribute_names[max_stroop_attributes];
+  size_t attribute_name_lengths[max_stroop_attributes];
+  long values[max_stroop_attributes];
+  const char *bad_attribute; // the first one missing or out of range
+
+  bool is(const char *tag) const {
+    return strlen(tag) == name_length && memcmp(tag, name, name_length) == 0;
+  }
+
+  long get(const char *attribute) {
+    size_t length = strlen(attribute);
+    for (int i = 0; i < num_attributes; i++) {
+      if (attribute_name_lengths[i] == length &&
+          memcmp(attribute_names[i], attribute, length) == 0) {
+        return values[i];
+      }
+    }
+    if (bad_attribute == nullptr) {
+      bad_attribute = attribute;
+    }
+    return 0;
+  }
+
+  // puts value in field, or blames attribute if the field can't hold it
+  template <typename field_t>
+  void store(const char *attribute, long value, field_t *field) {
+    if (value < std::numeric_limits<field_t>::min() ||
+        value > std::numeric_limits<field_t>::max()) {
+      if (bad_attribute == nullptr) {
+        bad_attribute = attribute;
+      }
+      return;
+    }
+    *field = value;
+  }
+
+  template <typename field_t> void read(const char *attribute, field_t *field) {
+    store(attribute, get(attribute), field);
+  }
+} stroop_tag_t;
+
+typedef struct stroop_object_t {
+  const char *tag;
+  int count; // how many of them objects_t has
+  void (*read)(stroop_tag_t *tag, int index, objects_t *state);
+} stroop_object_t;
+
+template <typename hand_or_wheel_t>
+void read_stroop_clock_hand(stroop_tag_t *tag, hand_or_wheel_t *h) {
+  tag->read("_angle", &h->angle);
+  tag->read("_targetAngle", &h->targetAngle);
+  tag->read("_timerMax", &h->max);
+  tag->read("_displacement", &h->displacement);
+  tag->read("_directionCountdown", &h->directionTimer);
+  tag->read("_timer", &h->timer);
+}
+
+const stroop_object_t stroop_objects[] = {
+    {"TtcRng", 1,
+     [](stroop_tag_t *tag, int, objects_t *state) {
+       tag->read("value", &state->rngValue);
+     }},
+    {"TtcRotatingBlock", 6,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       // counts down to the next rng call, rotating for 40 frames first
+       tag->store("_timer", 40 + tag->get("_timerMax") - tag->get("_timer"),
+                  &state->rotating_blocks[i].remaining_time);
+     }},
+    {"TtcRotatingTriangularPrism", 2,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       tag->read("_timerMax", &state->rotatingtriangularprisms[i].max);
+       tag->read("_timer", &state->rotatingtriangularprisms[i].timer);
+     }},
+    {"TtcPendulum", 4,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       pendulum_t &p = state->pendulums[i];
+       tag->read("_accelerationDirection", &p.accelerationDirection);
+       tag->read("_accelerationMagnitude", &p.accelerationMagnitude);
+       tag->read("_angle", &p.angle);
+       tag->read("_angularVelocity", &p.angularVelocity);
+       tag->read("_waitingTimer", &p.waitingTimer);
+     }},
+    {"TtcTreadmill", 1,
+     [](stroop_tag_t *tag, int, objects_t *state) {
+       tag->read("_currentSpeed", &state->treadmill.currentSpeed);
+       tag->read("_targetSpeed", &state->treadmill.targetSpeed);
+       tag->read("_timerMax", &state->treadmill.max);
+       tag->read("_timer", &state->treadmill.counter);
+     }},
+    {"TtcPusher", 12,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       pusher_t &p = state->pushers[i];
+       const long maxes[] = {1, 12, 55, 100};
+       long max = tag->get("_timerMax");
+       p.max_index = std::find(maxes, maxes + 4, max) - maxes;
+       if (p.max_index == 4 && tag->bad_attribute == nullptr) {
+         tag->bad_attribute = "_timerMax";
+       }
+       tag->read("_countdown", &p.countdown);
+       tag->read("_state", &p.state);
+       tag->read("_timer", &p.counter);
+     }},
+    {"TtcCog", 6,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       if (i == 0) {
+         tag->read("_currentAngularVelocity",
+                   &state->rcpscog.currentAngularVelocity);
+         tag->read("_targetAngularVelocity",
+                   &state->rcpscog.targetAngularVelocity);
+       } else {
+         cog_t &c = i == 5 ? state->sixthcog : state->cogs[i - 1];
+         tag->read("_currentAngularVelocity", &c.currentAngularVelocity);
+         tag->read("_targetAngularVelocity", &c.targetAngularVelocity);
+       }
+     }},
+    {"TtcSpinningTriangle", 2,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       spinningtriangle_t &st = state->spinningtriangles[i];
+       tag->read("_currentAngularVelocity", &st.currentAngularVelocity);
+       tag->read("_targetAngularVelocity", &st.targetAngularVelocity);
+     }},
+    {"TtcPitBlock", 1,
+     [](stroop_tag_t *tag, int, objects_t *state) {
+       tag->read("_height", &state->pitblock.height);
+       tag->read("_verticalSpeed", &state->pitblock.verticalSpeed);
+       tag->read("_direction", &state->pitblock.state);
+       tag->read("_timerMax", &state->pitblock.max);
+       tag->read("_timer", &state->pitblock.counter);
+     }},
+    {"TtcHand", 2,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       read_stroop_clock_hand(tag, &state->hands[i]);
+     }},
+    {"TtcSpinner", 14,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       tag->read("_timerMax", &state->spinners[i].max);
+       tag->read("_timer", &state->spinners[i].counter);
+     }},
+    {"TtcWheel", 6,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       read_stroop_clock_hand(tag, &state->wheels[i]);
+     }},
+    {"TtcElevator", 2,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       // counts down to the next rng call
+       tag->store("_timer", tag->get("_timerMax") - tag->get("_timer"),
+                  &state->elevators[i].counter);
+     }},
+    {"TtcThwomp", 1,
+     [](stroop_tag_t *tag, int, objects_t *state) {
+       tag->read("_height", &state->thwomp.height);
+       tag->read("_verticalSpeed", &state->thwomp.verticalSpeed);
+       tag->read("_timerMax", &state->thwomp.max);
+       tag->read("_state", &state->thwomp.state);
+       tag->read("_timer", &state->thwomp.counter);
+     }},
+    {"TtcBobomb", 2,
+     [](stroop_tag_t *tag, int i, objects_t *state) {
+       tag->read("_blinkingTimer", &state->bobombs[i].blinkingTimer);
+     }}};
+const int num_stroop_objects = sizeof(stroop_objects) / sizeof(*stroop_objects);
+
+inline bool is_name_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+/* reads a STROOP TtcState from text, printing what is wrong with it if it
+can't */
+bool parse_stroop_state(const char *text, size_t size, const char *path,
+                        objects_t *state) {
+  *state = objects_t{};
+  int found[num_stroop_objects] = {};
+  const char *p = text;
+  const char *end = text + size;
+  while ((p = (const char *)memchr(p, '<', end - p)) != nullptr) {
+    stroop_tag_t tag = {};
+    tag.name = ++p;
+    while (p < end && is_name_char(*p)) {
+      p++;
+    }
+    tag.name_length = p - tag.name;
+    if (tag.name_length == 0) {
+      continue; // a closing tag
+    }
+    // name="number" pairs up to the end of the tag
+    while (p < end && *p != '>') {
+      if (!is_name_char(*p)) {
+        p++;
+        continue;
+      }
+      const char *attribute = p;
+      while (p < end && is_name_char(*p)) {
+        p++;
+      }
+      size_t attribute_length = p - attribute;
+      if (end - p < 2 || p[0] != '=' || p[1] != '"') {
+        printf("%s: expected =\" after %.*s\n", path, (int)attribute_length,
+               attribute);
+        return false;
+      }
+      p += 2;
+      bool negative = p < end && *p == '-';
+      p += negative;
+      long value = 0;
+      const char *digits = p;
+      while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+      }
+      if (p == digits || p == end || *p != '"') {
+        printf("%s: %.*s is not a number\n", path, (int)attribute_length,
+               attribute);
+        return false;
+      }
+      p++;
+      if (tag.num_attributes < max_stroop_attributes) {
+        int a = tag.num_attributes++;
+        tag.attribute_names[a] = attribute;
+        tag.attribute_name_lengths[a] = attribute_length;
+        tag.values[a] = negative ? -value : value;
+      }
+    }
+    if (tag.is("TtcTreadmill") && tag.get("_subType") != 0) {
+      continue; // only the first treadmill is simulated
+    }
+    for (int kind = 0; kind < num_stroop_objects; kind++) {
+      const stroop_object_t &object = stroop_objects[kind];
+      if (!tag.is(object.tag)) {
+        continue;
+      }
+      if (found[kind] == object.count) {
+        printf("%s: more than %d %s\n", path, object.count, object.tag);
+        return false;
+      }
+      object.read(&tag, found[kind]++, state);
+      if (tag.bad_attribute != nullptr) {
+        printf("%s: %s %d has no usable %s\n", path, object.tag, found[kind],
+               tag.bad_attribute);
+        return false;
+      }
+    }
+  }
+  for (int kind = 0; kind < num_stroop_objects; kind++) {
+    if (found[kind] != stroop_objects[kind].count) {
+      printf("%s: expected %d %s, found %d\n", path, stroop_objects[kind].count,
+             stroop_objects[kind].tag, found[kind]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/* maps a STROOP file and reads the state in it */
+bool load_stroop_state(const char *path, objects_t *state) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    printf("%s: %s\n", path, strerror(errno));
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    printf("%s: empty or unreadable\n", path);
+    close(fd);
+    return false;
+  }
+  size_t size = file_stat.st_size;
+  void *text = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (text == MAP_FAILED) {
+    printf("%s: %s\n", path, strerror(errno));
+    return false;
+  }
+  bool loaded = parse_stroop_state((const char *)text, size, path, state);
+  munmap(text, size);
+  return loaded;
+}
+
+/* Telemetry for advanceobjects, picked at compile time. advanceobjects takes a
+policy and opens one of its object_scope_t around every object it runs, and
+advanceobjects_lanes one of its lanes_scope_t around every object's lanes. The
+default, no_telemetry_t, does nothing and compiles away. make TELEMETRY=1 makes
+object_telemetry_t the default instead, which counts for every kind of object
+how often it ran, how often it called rng, how many calls that was and how many
+cycles it took, a lane counting as a run, and prints them to stderr at exit. It
+can also note which objects called rng on a frame, which is what --rng-trace
+shows in any build.
+
+The event engine only runs objects on their rng frames, so it isn't broken
+down by object. Every engine counts the frames it simulates though, and the
+printout says what share of them the object counts cover.
+
+pollRNG fills tables at compile time, so rather than hooking it a scope counts
+the calls by how far the rng moved along its cycle, which comes to the same. */
+enum object_kind_t {
+  rotating_block_kind,
+  rotating_triangular_prism_kind,
+  pendulum_kind,
+  treadmill_kind,
+  pusher_kind,
+  rcpscog_kind,
+  cog_kind,
+  spinning_triangle_kind,
+  pit_block_kind,
+  hand_kind,
+  spinner_kind,
+  wheel_kind,
+  elevator_kind,
+  sixth_cog_kind,
+  thwomp_kind,
+  bobomb_kind,
+  num_object_kinds
+};
+const char *object_kind_names[num_object_kinds] = {
+    "rotating block",
+    "rotating triangular prism",
+    "pendulum",
+    "treadmill",
+    "pusher",
+    "rcpscog",
+    "cog",
+    "spinning triangle",
+    "pit block",
+    "hand",
+    "spinner",
+    "wheel",
+    "elevator",
+    "sixth cog",
+    "thwomp",
+    "bobomb"};
+
+enum telemetry_engine_t {
+  scalar_engine,
+  lanes_engine,
+  event_engine,
+  num_telemetry_engines
+};
+const char *telemetry_engine_names[num_telemetry_engines] = {
+    "advanceobjects", "lanes", "event engine"};
+
+// lanes_scope_t takes the lane vector type as a parameter, as it comes later
+typedef struct no_telemetry_t {
+  typedef struct object_scope_t {
+    object_scope_t(object_kind_t, int, const unsigned short *) {}
+  } object_scope_t;
+  template <typename lanes_t> struct lanes_scope_t {
+    lanes_scope_t(object_kind_t, const lanes_t *, lanes_t) {}
+  };
+  static void count_frames(telemetry_engine_t, uint64_t) {}
+} no_telemetry_t;
+
+/* how many rng calls take the rng from before to after */
+inline int rng_calls_between(unsigned short before, unsigned short after) {
+  int calls = 0;
+  // values off the cycle lead onto it
+  while (before != after && rng_value_to_index[before] < 0) {
+    pollRNG(&before);
+    calls++;
+  }
+  return calls + (rng_value_to_index[after] - rng_value_to_index[before] +
+                  rng_cycle_length) %
+                     rng_cycle_length;
+}
+
+typedef struct rng_attribution_t {
+  object_kind_t kind;
+  int index; // which of the objects of its kind
+  int calls;
+} rng_attribution_t;
+
+typedef struct object_telemetry_t {
+  static inline std::atomic<uint64_t> runs[num_object_kinds];
+  static inline std::atomic<uint64_t> runs_calling_rng[num_object_kinds];
+  static inline std::atomic<uint64_t> rng_calls[num_object_kinds];
+  static inline std::atomic<uint64_t> cycles[num_object_kinds];
+  static inline std::atomic<uint64_t> frames[num_telemetry_engines];
+  // if set, every object that calls rng is appended to it
+  static inline thread_local std::vector<rng_attribution_t> *trace = nullptr;
+
+  class object_scope_t {
+  public:
+    object_scope_t(object_kind_t kind, int index,
+                   const unsigned short *rngValue)
+        : kind(kind), index(index), rngValue(rngValue), rng_before(*rngValue),
+          started(read_cycles()) {}
+    ~object_scope_t() {
+      cycles[kind].fetch_add(read_cycles() - started,
+                             std::memory_order_relaxed);
+      runs[kind].fetch_add(1, std::memory_order_relaxed);
+      if (*rngValue == rng_before) {
+        return;
+      }
+      int calls = rng_calls_between(rng_before, *rngValue);
+      runs_calling_rng[kind].fetch_add(1, std::memory_order_relaxed);
+      rng_calls[kind].fetch_add(calls, std::memory_order_relaxed);
+      if (trace != nullptr) {
+        trace->push_back({kind, index, calls});
+      }
+    }
+
+  private:
+    object_kind_t kind;
+    int index;
+    const unsigned short *rngValue;
+    unsigned short rng_before;
+    uint64_t started;
+  };
+
+  // the same for one object in every active lane, each lane counting as a run
+  template <typename lanes_t> class lanes_scope_t {
+  public:
+    lanes_scope_t(object_kind_t kind, const lanes_t *rngValue, lanes_t active)
+        : kind(kind), rngValue(rngValue), rng_before(*rngValue),
+          active(active), started(read_cycles()) {}
+    ~lanes_scope_t() {
+      cycles[kind].fetch_add(read_cycles() - started,
+                             std::memory_order_relaxed);
+      uint64_t lanes = 0;
+      uint64_t lanes_calling_rng = 0;
+      uint64_t calls = 0;
+      for (size_t lane = 0; lane < sizeof(lanes_t) / sizeof(active[0]);
+           lane++) {
+        if (!active[lane]) {
+          continue;
+        }
+        lanes++;
+        if ((*rngValue)[lane] != rng_before[lane]) {
+          lanes_calling_rng++;
+          calls += rng_calls_between(rng_before[lane], (*rngValue)[lane]);
+        }
+      }
+      runs[kind].fetch_add(lanes, std::memory_order_relaxed);
+      runs_calling_rng[kind].fetch_add(lanes_calling_rng,
+                                       std::memory_order_relaxed);
+      rng_calls[kind].fetch_add(calls, std::memory_order_relaxed);
+    }
+
+  private:
+    object_kind_t kind;
+    const lanes_t *rngValue;
+    lanes_t rng_before;
+    lanes_t active;
+    uint64_t started;
+  };
+
+  static void count_frames(telemetry_engine_t engine, uint64_t count) {
+    frames[engine].fetch_add(count, std::memory_order_relaxed);
+  }
+
+  /* writes the counts so far as one JSON line to stderr */
+  static void print() {
+    uint64_t all_frames = 0;
+    fprintf(stderr, "{\"frames\": {");
+    for (int engine = 0; engine < num_telemetry_engines; engine++) {
+      uint64_t engine_frames = frames[engine].load(std::memory_order_relaxed);
+      all_frames += engine_frames;
+      fprintf(stderr, "%s\"%s\": %lu", engine == 0 ? "" : ", ",
+              telemetry_engine_names[engine], (unsigned long)engine_frames);
+    }
+    uint64_t covered = all_frames - frames[event_engine].load();
+    fprintf(stderr, "}, \"objects_cover\": %.4f, \"objects\": [",
+            all_frames == 0 ? 0.0 : (double)covered / all_frames);
+    for (int kind = 0; kind < num_object_kinds; kind++) {
+      uint64_t kind_runs = runs[kind].load(std::memory_order_relaxed);
+      uint64_t kind_cycles = cycles[kind].load(std::memory_order_relaxed);
+      fprintf(stderr,
+              "%s{\"kind\": \"%s\", \"runs\": %lu, \"runs_calling_rng\": %lu, "
+              "\"rng_calls\": %lu, \"cycles\": %lu, \"cycles_per_run\": %.1f}",
+              kind == 0 ? "" : ", ", object_kind_names[kind],
+              (unsigned long)kind_runs,
+              (unsigned long)runs_calling_rng[kind].load(
+                  std::memory_order_relaxed),
+              (unsigned long)rng_calls[kind].load(std::memory_order_relaxed),
+              (unsigned long)kind_cycles,
+              kind_runs == 0 ? 0.0 : (double)kind_cycles / kind_runs);
+    }
+    fprintf(stderr, "]}\n");
+  }
+} object_telemetry_t;
+
+#ifdef RCPS_TELEMETRY
+typedef object_telemetry_t default_telemetry_t;
+#else
+typedef no_telemetry_t default_telemetry_t;
+#endif
 
 /* moves objects forward one frame */
+template <typename telemetry = default_telemetry_t>
 void advanceobjects(objects_t *objects) {
+  typedef typename telemetry::object_scope_t scope_t;
+  telemetry::count_frames(scalar_engine, 1);
+  unsigned short *rng = &objects->rngValue;
   int i;
   for (i = 0; i < 6; i++) {
-    rotatingblock(&objects->rotating_blocks[i], &objects->rngValue);
+    scope_t scope(rotating_block_kind, i, rng);
+    rotatingblock(&objects->rotating_blocks[i], rng);
   }
   for (i = 0; i < 2; i++) {
-    rotatingtriangularprism(&objects->rotatingtriangularprisms[i],
-                            &objects->rngValue);
+    scope_t scope(rotating_triangular_prism_kind, i, rng);
+    rotatingtriangularprism(&objects->rotatingtriangularprisms[i], rng);
   }
   for (i = 0; i < 4; i++) {
-    pendulum(&objects->pendulums[i], &objects->rngValue);
+    scope_t scope(pendulum_kind, i, rng);
+    pendulum(&objects->pendulums[i], rng);
+  }
+  {
+    scope_t scope(treadmill_kind, 0, rng);
+    treadmill(&objects->treadmill, rng);
   }
-  treadmill(&objects->treadmill, &objects->rngValue);
   for (i = 0; i < 12; i++) {
-    pusher(&objects->pushers[i], &objects->rngValue);
+    scope_t scope(pusher_kind, i, rng);
+    pusher(&objects->pushers[i], rng);
+  }
+  {
+    scope_t scope(rcpscog_kind, 0, rng);
+    rcpscog(&objects->rcpscog, rng);
   }
-  rcpscog(&objects->rcpscog, &objects->rngValue);
   if (objects->rcpscog.small_enough_movement_so_far == 0) {
     return;
   }
   for (i = 0; i < 4; i++) {
-    cog(&objects->cogs[i], &objects->rngValue);
+    scope_t scope(cog_kind, i, rng);
+    cog(&objects->cogs[i], rng);
   }
   for (i = 0; i < 2; i++) {
-    spinningtriangle(&objects->spinningtriangles[i], &objects->rngValue);
+    scope_t scope(spinning_triangle_kind, i, rng);
+    spinningtriangle(&objects->spinningtriangles[i], rng);
+  }
+  {
+    scope_t scope(pit_block_kind, 0, rng);
+    pitblock(&objects->pitblock, rng);
   }
-  pitblock(&objects->pitblock, &objects->rngValue);
   for (i = 0; i < 2; i++) {
-    hand(&objects->hands[i], &objects->rngValue);
+    scope_t scope(hand_kind, i, rng);
+    hand(&objects->hands[i], rng);
   }
   for (i = 0; i < 14; i++) {
-    spinner(&objects->spinners[i], &objects->rngValue);
+    scope_t scope(spinner_kind, i, rng);
+    spinner(&objects->spinners[i], rng);
   }
   for (i = 0; i < 6; i++) {
-    wheel(&objects->wheels[i], &objects->rngValue);
+    scope_t scope(wheel_kind, i, rng);
+    wheel(&objects->wheels[i], rng);
   }
   for (i = 0; i < 2; i++) {
-    elevator(&objects->elevators[i], &objects->rngValue);
+    scope_t scope(elevator_kind, i, rng);
+    elevator(&objects->elevators[i], rng);
+  }
+  {
+    scope_t scope(sixth_cog_kind, 0, rng);
+    cog(&objects->sixthcog, rng);
+  }
+  {
+    scope_t scope(thwomp_kind, 0, rng);
+    thwomp(&objects->thwomp, rng);
   }
-  cog(&objects->sixthcog, &objects->rngValue);
-  thwomp(&objects->thwomp, &objects->rngValue);
   for (i = 0; i < 2; i++) {
-    bobomb(&objects->bobombs[i], &objects->rngValue);
+    scope_t scope(bobomb_kind, i, rng);
+    bobomb(&objects->bobombs[i], rng);
   }
 }
 
-void randomizearray(objects_t *inputstate) {
-  int a;
-  for (a = 0; a < 6; a++) {
-    // inputstate->rotating_blocks[a].max = randbetween<0, 6>() * 20 + 5;
-    // inputstate->rotating_blocks[a].timer =
-    //     randbetween(0, ((inputstate->rotating_blocks[a].max + 40) / 5) * 5);
-    inputstate->rotating_blocks[a].remaining_time = randbetween<0, 165>();
+/* Event driven simulation. Between two of its rng calls every object only
+counts timers and moves along fixed paths, and those stretches have closed
+forms. So instead of running every object every frame, each object keeps the
+frame of its next rng call and the state it had when it was last brought up to
+date, only the objects that call rng on a frame are run on it, and frames where
+nothing calls rng are jumped over. Like the pusher's transition table but for
+every object, and whole stretches at a time. The rng calls of a frame still
+happen in advanceobjects order. */
+
+// frames until an object that never calls rng again would do so
+const int never = 1 << 20;
+
+/* smallest j >= 1 with a*j*j + b*j + c > 0, for a > 0 */
+long long first_positive_quadratic(long long a, long long b, long long c) {
+  auto f = [&](long long j) { return a * j * j + b * j + c; };
+  if (f(1) > 0) {
+    return 1;
   }
-  for (a = 0; a < 2; a++) {
-    inputstate->rotatingtriangularprisms[a].max = randbetween<0, 6>() * 20 + 5;
-    inputstate->rotatingtriangularprisms[a].timer = randbetween(
-        0, ((inputstate->rotatingtriangularprisms[a].max + 45) / 5) * 5);
+  // f(1) <= 0 so there is a larger root, start just past it and correct the
+  // rounding of the square root by stepping
+  double root = (-b + std::sqrt((double)b * b - 4.0 * a * c)) / (2.0 * a);
+  long long j = std::max(2LL, (long long)root + 1);
+  while (j > 2 && f(j - 1) > 0) {
+    j--;
   }
-  for (a = 0; a < 4; a++) {
-    inputstate->pendulums[a].waitingTimer = randbetween<0, 34>();
-    inputstate->pendulums[a].accelerationDirection =
-        randbetween<0, 1>() * 2 - 1;
-    inputstate->pendulums[a].angle = randbetween<0, 1000>() * 13 - 6500;
-    inputstate->pendulums[a].angularVelocity = randbetween<1, 5>() * 21 - 63;
-    inputstate->pendulums[a].accelerationMagnitude =
-        randbetween<0, 1>() * 29 + 13;
+  while (f(j) <= 0) {
+    j++;
   }
-  inputstate->treadmill.currentSpeed = randbetween<-5, 5>() * 10;
-  inputstate->treadmill.targetSpeed = randbetween<0, 1>() * 100 - 50;
-  inputstate->treadmill.max = randbetween<0, 6>() * 20 + 10;
-  inputstate->treadmill.counter =
-      randbetween(0, ((inputstate->treadmill.max) / 5) * 5);
-  for (a = 0; a < 12; a++) {
-    inputstate->pushers[a].max_index = randbetween<0, 3>();
-    inputstate->pushers[a].countdown = randbetween<0, 119>();
-    inputstate->pushers[a].state = randbetween<0, 3>();
-    inputstate->pushers[a].counter = randbetween(
-        0, ((max_index_to_max[inputstate->pushers[a].max_index]) / 5) * 5);
+  return j;
+}
+
+/* For each object type, linear_frames says how many of the upcoming frames
+are plain (no rng call and no change of phase) and skip_linear jumps over up
+to that many of them. Anything else is done by running the object itself.
+linear_frames gives calls_rng_next when the very next frame calls rng.
+never_calls_rng says when it can tell from the state alone that the object
+won't call rng again, so there is no need to walk there. */
+
+const int calls_rng_next = -1;
+
+template <typename T> bool never_calls_rng(const T &) { return false; }
+
+int linear_frames(const rotatingblock_t &rb) {
+  if (rb.remaining_time == 0) {
+    return calls_rng_next;
   }
-  inputstate->rcpscog.currentAngularVelocity = 0;
-  inputstate->rcpscog.targetAngularVelocity = 0;
-  for (a = 0; a < 4; a++) {
-    inputstate->cogs[a].currentAngularVelocity = randbetween<-24, 24>() * 50;
-    inputstate->cogs[a].targetAngularVelocity = randbetween<-6, 6>() * 20;
+  return rb.remaining_time > 0 ? rb.remaining_time : never;
+}
+void skip_linear(rotatingblock_t *rb, int frames) {
+  rb->remaining_time -= frames;
+}
+
+int linear_frames(const rotatingtriangularprism_t &rtp) {
+  return rtp.timer >= rtp.max + 45 ? calls_rng_next
+                                   : rtp.max + 45 - rtp.timer;
+}
+void skip_linear(rotatingtriangularprism_t *rtp, int frames) {
+  rtp->timer += frames;
+}
+
+// the direction a swinging pendulum accelerates in on its next frame
+int pendulum_direction(const pendulum_t &p) {
+  return p.angle > 0 ? -1 : (p.angle < 0 ? 1 : p.accelerationDirection);
+}
+
+/* whether swinging j frames towards d keeps the angle and velocity inside
+int16_t, past that the pendulum wraps them around and the closed form is off.
+The velocity only grows towards d and the angle only bends towards d, so the
+ends and the turning point are the only frames to look at */
+bool pendulum_swing_fits(const pendulum_t &p, int d, long long j) {
+  if (j <= 0) {
+    return true;
   }
-  for (a = 0; a < 2; a++) {
-    inputstate->spinningtriangles[a].currentAngularVelocity =
-        randbetween<-24, 24>() * 50;
-    inputstate->spinningtriangles[a].targetAngularVelocity =
-        randbetween<-6, 6>() * 20;
-  }
-  inputstate->pitblock.height = randbetween<0, 30>() * 11 - 71;
-  inputstate->pitblock.verticalSpeed = randbetween<0, 1>() * 20 - 9;
-  inputstate->pitblock.state = randbetween<0, 1>();
-  inputstate->pitblock.max = (randbetween<0, 6>() * 20 + 9) % 110 + 1;
-  inputstate->pitblock.counter = randbetween(0, inputstate->pitblock.max);
-  for (a = 0; a < 2; a++) {
-    inputstate->hands[a].angle = randbetween<-6, 6>() * 182;
-    inputstate->hands[a].max = randbetween<0, 2>() * 20 + 10;
-    inputstate->hands[a].targetAngle = randbetween<-1, 1>() * 1092;
-    inputstate->hands[a].displacement = (randbetween<0, 1>() * 2 - 1) * 1092;
-    inputstate->hands[a].directionTimer =
-        (randbetween<0, 5>() * 60 + 29) % 270 + 1;
-    inputstate->hands[a].timer = randbetween(0, inputstate->hands[a].max);
+  long long v = p.angularVelocity, m = p.accelerationMagnitude;
+  auto angle = [&](long long k) {
+    return p.angle + k * v + d * m * k * (k + 1) / 2;
+  };
+  auto fits = [](long long x) {
+    return x >= std::numeric_limits<int16_t>::min() &&
+           x <= std::numeric_limits<int16_t>::max();
+  };
+  long long turn = std::min(std::max((-d * v) / m, 1LL), j);
+  return fits(v + d * m) && fits(v + d * m * j) && fits(angle(1)) &&
+         fits(angle(j)) && fits(angle(turn)) &&
+         fits(angle(std::min(turn + 1, j)));
+}
+
+int linear_frames(const pendulum_t &p) {
+  if (p.waitingTimer > 0) {
+    return p.waitingTimer;
   }
-  for (a = 0; a < 14; a++) {
-    // inputstate->spinners[a].direction = randbetween<0, 1>() * 2 - 1;
-    inputstate->spinners[a].max = randbetween<0, 3>() * 30 + 30;
-    inputstate->spinners[a].counter =
-        randbetween(0, inputstate->spinners[a].max);
+  int d = pendulum_direction(p);
+  long long m = p.accelerationMagnitude;
+  if (m <= 0 || d == 0) {
+    return 0;
   }
-  for (a = 0; a < 6; a++) {
-    inputstate->wheels[a].max = randbetween<0, 2>() * 20 + 10;
-    inputstate->wheels[a].angle = randbetween<-14, 14>() * 234;
-    inputstate->wheels[a].targetAngle = randbetween<-1, 1>() * 3276;
-    inputstate->wheels[a].displacement = (randbetween<0, 1>() * 2 - 1) * 3276;
-    inputstate->wheels[a].directionTimer =
-        (randbetween<0, 5>() * 60 + 29) % 270 + 1;
-    inputstate->wheels[a].timer = randbetween(0, inputstate->wheels[a].max);
+  // after j frames the velocity is v + d*m*j and the angle has moved by
+  // j*v + d*m*j*(j+1)/2, the swing calls rng when the velocity hits 0 and the
+  // direction flips once the angle crosses to the other side
+  long long v = p.angularVelocity;
+  long long frames = never;
+  if (-v * d > 0 && (-v * d) % m == 0) {
+    frames = (-v * d) / m - 1;
+    if (frames == 0) {
+      return calls_rng_next;
+    }
   }
-  for (a = 0; a < 2; a++) {
-    // inputstate->elevators[a].max = randbetween<1, 6>() * 30;
-    inputstate->elevators[a].counter = randbetween(0, 180);
+  long long flip =
+      first_positive_quadratic(m, m + 2 * d * v, 2LL * d * p.angle);
+  frames = std::min(frames, flip);
+  if (!pendulum_swing_fits(p, d, frames)) {
+    // the last frames wrap around, leave them to the pendulum itself
+    long long lo = 0;
+    while (lo + 1 < frames) {
+      long long mid = (lo + frames) / 2;
+      if (pendulum_swing_fits(p, d, mid)) {
+        lo = mid;
+      } else {
+        frames = mid;
+      }
+    }
+    frames = lo;
   }
-  inputstate->sixthcog.currentAngularVelocity = randbetween<-24, 24>() * 50;
-  inputstate->sixthcog.targetAngularVelocity = randbetween<-6, 6>() * 20;
-  inputstate->thwomp.height = randbetween<6192, 6607>();
-  inputstate->thwomp.max = randbetween<10, 39>();
-  inputstate->thwomp.counter = randbetween(0, inputstate->thwomp.max);
-  inputstate->thwomp.state = randbetween<0, 4>();
-  inputstate->thwomp.verticalSpeed = randbetween<0, 104>() * -4;
-  for (a = 0; a < 2; a++) {
-    inputstate->bobombs[a].blinkingTimer = randbetween<0, 15>();
+  return (int)frames;
+}
+// every swinging frame moves the velocity by m one way or the other, and
+// waiting leaves it alone, so unless it is a multiple of m it never hits 0 and
+// the pendulum swings forever without calling rng. Wrapping the velocity
+// around would change that, but the swing takes millions of frames to grow
+// that far, well past never
+bool never_calls_rng(const pendulum_t &p) {
+  return p.accelerationMagnitude > 0 &&
+         p.angularVelocity % p.accelerationMagnitude != 0;
+}
+void skip_linear(pendulum_t *p, int frames) {
+  if (p->waitingTimer > 0) {
+    p->waitingTimer -= frames;
+    return;
   }
+  int d = pendulum_direction(*p);
+  p->accelerationDirection = d;
+  p->angle += frames * p->angularVelocity +
+              d * p->accelerationMagnitude * frames * (frames + 1) / 2;
+  p->angularVelocity += d * p->accelerationMagnitude * frames;
 }
 
-void printobjectstates(const objects_t *const inputstate) {
-  int a;
-  for (a = 0; a < 6; a++) {
-    // printf("Rotating Block %i max: %i\n", a + 1,
-    //        inputstate->rotating_blocks[a].max);
-    // printf("Rotating Block %i timer: %i\n", a + 1,
-    //        inputstate->rotating_blocks[a].timer);
-    printf("Rotating Block %i remaining time: %i\n", a + 1,
-           inputstate->rotating_blocks[a].remaining_time);
+int linear_frames(const treadmill_t &tr) {
+  if (tr.counter <= tr.max) {
+    if (tr.counter <= 5) {
+      return std::min((int)tr.max, 5) - tr.counter + 1;
+    }
+    return tr.max - tr.counter + 1;
   }
-  for (a = 0; a < 2; a++) {
-    printf("Rotating Triangular Prism %i max: %i, timer: %i\n", a + 1,
-           inputstate->rotatingtriangularprisms[a].max,
-           inputstate->rotatingtriangularprisms[a].timer);
+  // slowing down, the frame it reaches 0 calls rng
+  if (std::abs(tr.currentSpeed) <= 10) {
+    return calls_rng_next;
   }
-  for (a = 0; a < 4; a++) {
-    printf("Pendulum %i waiting timer: %i, acceleration direction: %i,\
- angle: %i, angular velocity: %i, acceleration magnitude: %i\n", a + 1,
-           inputstate->pendulums[a].waitingTimer,
-           inputstate->pendulums[a].accelerationDirection,
-           inputstate->pendulums[a].angle,
-           inputstate->pendulums[a].angularVelocity,
-           inputstate->pendulums[a].accelerationMagnitude);
+  return (std::abs(tr.currentSpeed) - 1) / 10;
+}
+void skip_linear(treadmill_t *tr, int frames) {
+  if (tr->counter > tr->max) {
+    tr->currentSpeed = moveNumberTowards(tr->currentSpeed, 0, 10 * frames);
+  } else if (tr->counter > 5) {
+    tr->currentSpeed =
+        moveNumberTowards(tr->currentSpeed, tr->targetSpeed, 10 * frames);
   }
-  printf("Treadmill current speed: %i, target speed: %i, max: %i, counter: %i\n",
-           inputstate->treadmill.currentSpeed,
-           inputstate->treadmill.targetSpeed,
-           inputstate->treadmill.max,
-           inputstate->treadmill.counter);
-  for (a = 0; a < 12; a++) {
-    printf("Pusher %i max: %i, countdown: %i, state: %i, counter: %i\n", a + 1,
-           max_index_to_max[inputstate->pushers[a].max_index],
-           inputstate->pushers[a].countdown,
-           inputstate->pushers[a].state,
-           inputstate->pushers[a].counter);
+  tr->counter += frames;
+}
+
+int linear_frames(const pusher_t &p) {
+  if (p.state == 0) {
+    if (p.counter <= max_index_to_max[p.max_index]) {
+      return max_index_to_max[p.max_index] - p.counter + 1;
+    }
+    return p.countdown > 0 ? p.countdown : calls_rng_next;
+  } else if (p.state == 1) {
+    return p.counter < 10 ? 10 - p.counter : p.countdown;
+  } else if (p.state == 2) {
+    if (p.counter == 1) {
+      return calls_rng_next;
+    }
+    return p.counter >= 2 ? std::max(0, 36 - p.counter) : 0;
   }
-  printf("RCPS Cog current angular velocity: %i, target angular velocity: %i\n",
-           inputstate->rcpscog.currentAngularVelocity,
-           inputstate->rcpscog.targetAngularVelocity);
-  for (a = 0; a < 4; a++) {
-    printf("Cog %i current angular velocity: %i, target angular velocity: %i\n",
-           a + 2,
-           inputstate->cogs[a].currentAngularVelocity,
-           inputstate->cogs[a].targetAngularVelocity);
+  return std::max(0, 82 - p.counter);
+}
+void skip_linear(pusher_t *p, int frames) {
+  if ((p->state == 0 && p->counter > max_index_to_max[p->max_index]) ||
+      (p->state == 1 && p->counter >= 10)) {
+    p->countdown -= frames;
   }
-  for (a = 0; a < 2; a++) {
-    printf("Spinning Triangle %i current angular velocity: %i,\
- target angular velocity: %i\n", a + 1,
-           inputstate->spinningtriangles[a].currentAngularVelocity,
-           inputstate->spinningtriangles[a].targetAngularVelocity);
+  p->counter += frames;
+}
+
+/* cogs and spinning triangles move 50 towards their target every frame and
+call rng on the frame they reach it, a target that is not a multiple of 50
+away is never reached and the velocity ends up flipping around it */
+template <typename T> int cog_linear_frames(const T &c) {
+  int diff = std::abs(c.targetAngularVelocity - c.currentAngularVelocity);
+  if (diff % 50 != 0) {
+    return never;
   }
-  printf("Pit Block height: %i, vertical speed: %i, state: %i, max: %i,\
- counter: %i\n",
-           inputstate->pitblock.height,
-           inputstate->pitblock.verticalSpeed,
-           inputstate->pitblock.state,
-           inputstate->pitblock.max,
-           inputstate->pitblock.counter);
-  for (a = 0; a < 2; a++) {
-    printf("Hand %i angle: %i, max: %i, target angle: %i, displacement: %i,\
- direction timer: %i, timer: %i\n", a + 1,
-           inputstate->hands[a].angle,
-           inputstate->hands[a].max,
-           inputstate->hands[a].targetAngle,
-           inputstate->hands[a].displacement,
-           inputstate->hands[a].directionTimer,
-           inputstate->hands[a].timer);
+  return diff <= 50 ? calls_rng_next : diff / 50 - 1;
+}
+template <typename T> void cog_skip_linear(T *c, int frames) {
+  int diff = c->targetAngularVelocity - c->currentAngularVelocity;
+  int sign = diff > 0 ? 1 : -1;
+  int towards = std::min(frames, std::abs(diff) / 50);
+  c->currentAngularVelocity += sign * 50 * towards;
+  if ((frames - towards) % 2 == 1) {
+    c->currentAngularVelocity += sign * 50;
   }
-  for (a = 0; a < 14; a++) {
-    // printf("Spinner %i direction: %i \n", a + 1,
-    //        inputstate->spinners[a].direction);
-    printf("Spinner %i max: %i, counter: %i\n", a + 1,
-           inputstate->spinners[a].max,
-           inputstate->spinners[a].counter);
+}
+
+int linear_frames(const cog_t &c) { return cog_linear_frames(c); }
+void skip_linear(cog_t *c, int frames) { cog_skip_linear(c, frames); }
+int linear_frames(const rcpscog_t &c) { return cog_linear_frames(c); }
+void skip_linear(rcpscog_t *c, int frames) { cog_skip_linear(c, frames); }
+int linear_frames(const spinningtriangle_t &st) {
+  return cog_linear_frames(st);
+}
+void skip_linear(spinningtriangle_t *st, int frames) {
+  cog_skip_linear(st, frames);
+}
+
+int linear_frames(const pitblock_t &p) {
+  if (p.counter <= p.max) {
+    return p.max - p.counter + 1;
   }
-  for (a = 0; a < 6; a++) {
-    printf("Wheel %i max: %i, angle: %i, target angle: %i, displacement: %i,\
- direction timer: %i, timer: %i\n", a + 1,
-           inputstate->wheels[a].max,
-           inputstate->wheels[a].angle,
-           inputstate->wheels[a].targetAngle,
-           inputstate->wheels[a].displacement,
-           inputstate->wheels[a].directionTimer,
-           inputstate->wheels[a].timer);
+  // moving, count the frames before it clamps to -71 or hits 259
+  long long h = p.height, vs = p.verticalSpeed;
+  // the counter is a byte and the height 16 bits, and a step wraps them, which
+  // only a randomized state lives long enough to do, so stop short of that and
+  // leave it to the step
+  long long frames = 256 - p.counter;
+  if (vs < 0) {
+    frames = std::min(frames, (h + 32768) / -vs);
+  } else if (vs > 0) {
+    frames = std::min(frames, (32767 - h) / vs);
   }
-  for (a = 0; a < 2; a++) {
-    // printf("Elevator %i max: %i \n", a + 1, inputstate->elevators[a].max);
-    printf("Elevator %i counter: %i\n", a + 1,
-           inputstate->elevators[a].counter);
+  if (p.state == 0) {
+    if (h + vs >= -71) {
+      return calls_rng_next;
+    } else if (vs > 0) {
+      frames = std::min(frames, (-71 - h + vs - 1) / vs - 1);
+    }
+    return (int)std::max(0LL, frames);
   }
-  printf("Cog 6 current angular velocity: %i, target angular velocity: %i\n",
-         inputstate->sixthcog.currentAngularVelocity,
-         inputstate->sixthcog.targetAngularVelocity);
-  printf("Thwomp height: %i, max: %i, counter: %i, state: %i, vertical speed: %i\n",
-           inputstate->thwomp.height,
-           inputstate->thwomp.max,
-           inputstate->thwomp.counter,
-           inputstate->thwomp.state,
-           inputstate->thwomp.verticalSpeed);
-  for (a = 0; a < 2; a++) {
-    printf("Bobomb %i blinking timer: %i\n", a + 1,
-           inputstate->bobombs[a].blinkingTimer);
+  if (vs < 0) {
+    frames = std::min(frames, (h + 71 - vs - 1) / -vs - 1);
+    if (h > 259 && (h - 259) % -vs == 0) {
+      frames = std::min(frames, (h - 259) / -vs - 1);
+    }
+  } else if (vs > 0 && h < 259 && (259 - h) % vs == 0) {
+    frames = std::min(frames, (259 - h) / vs - 1);
   }
-  printf("RNGvalue: %i\n", inputstate->rngValue);
+  if (h + vs <= -71 || h + vs == 259) {
+    frames = 0;
+  }
+  return (int)std::max(0LL, frames);
+}
+void skip_linear(pitblock_t *p, int frames) {
+  if (p->counter > p->max) {
+    p->height += frames * p->verticalSpeed;
+  }
+  p->counter += frames;
 }
 
-const int num_seeds = 65114;
-unsigned short rngSeeds[num_seeds];
-
-std::pair<int, int> steps_still_for_state(objects_t *currentstartingarray,
-                                          int seed_idx = -1) {
-  objects_t states;
-  int max_still = 0;
-  int seed_idx_for_max_still = 0;
-  int start = 0;
-  int end = num_seeds;
-  if (seed_idx != -1) {
-    start = std::max(seed_idx - 5, 0);
-    end = std::min(num_seeds, seed_idx + 5);
+/* hands and wheels call rng on the first frame that their timer is past max
+and they are at their target angle */
+template <typename T> int clock_hand_linear_frames(const T &h) {
+  if (h.max == 0) {
+    return 0;
   }
-  for (int i = start; i < end; i++) {
-    memcpy(&states, currentstartingarray, sizeof(objects_t));
-    states.rngValue = rngSeeds[i];
-    states.rcpscog.small_enough_movement_so_far = 1;
-    int a = 0;
-    while(states.rcpscog.small_enough_movement_so_far != 0){
-      advanceobjects(&states);
-      a++;
-    }
-    // for (a = 0; a < 1200; a++) {
-    //   advanceobjects(&states);
-    //   if (states.rcpscog.small_enough_movement_so_far == 0) {
-    //     break;
-    //   }
-    // }
-    // if (states.rcpscog.small_enough_movement_so_far == 1) {
-    //   printf("cog was still the whole time !!!\n");
-    //   printobjectstates(currentstartingarray);
-    //   exit(0);
-    //   break;
-    // }
-    if (a > max_still) {
-      max_still = a;
-      seed_idx_for_max_still = i;
+  int reach;
+  if (h.angle == h.targetAngle) {
+    reach = 0;
+  } else if (h.targetAngle < 0 || h.targetAngle > 65535) {
+    return never; // angles are normalized once they move
+  } else {
+    int diff = (h.targetAngle - h.angle + 65536) % 65536;
+    int distance = diff < 32768 ? diff : 65536 - diff;
+    reach = std::max(1, (distance + 199) / 200);
+  }
+  int frames = std::max({1, reach, h.max - h.timer + 2}) - 1;
+  return frames == 0 ? calls_rng_next : frames;
+}
+template <typename T> void clock_hand_skip_linear(T *h, int frames) {
+  if (h->targetAngle < 0 || h->targetAngle > 65535) {
+    // the angle settles on the normalized target, but does not always get
+    // there the shorter way, so move it one frame at a time
+    int settled = normalize(h->targetAngle);
+    for (int i = 0; i < frames && h->angle != settled; i++) {
+      h->angle = moveAngleTowards(h->angle, h->targetAngle, 200);
     }
+  } else {
+    h->angle = moveAngleTowards(h->angle, h->targetAngle, 200 * frames);
   }
-  return {max_still, seed_idx_for_max_still};
+  h->directionTimer = std::max(0, h->directionTimer - frames);
+  h->timer += frames;
 }
 
-long states_checked = 0;
-int most_frames_lasted = 0;
-// double initial_temperature = 0.125;
-// int ticker = 10;
+int linear_frames(const hand_t &h) { return clock_hand_linear_frames(h); }
+void skip_linear(hand_t *h, int frames) { clock_hand_skip_linear(h, frames); }
+int linear_frames(const wheel_t &w) { return clock_hand_linear_frames(w); }
+void skip_linear(wheel_t *w, int frames) { clock_hand_skip_linear(w, frames); }
 
-std::map<long, long> found_per_length;
+int linear_frames(const spinner_t &sp) {
+  return sp.counter > sp.max ? calls_rng_next : sp.max + 1 - sp.counter;
+}
+void skip_linear(spinner_t *sp, int frames) { sp->counter += frames; }
 
-void check_small_changes(int best_so_far, objects_t *inputstate,
-                         int steps_since_last_increase, int depth = 0,
-                         int seed_idx = -1);
+int linear_frames(const elevator_t &e) {
+  if (e.counter == 0) {
+    return calls_rng_next;
+  }
+  return e.counter > 0 ? e.counter : never;
+}
+void skip_linear(elevator_t *e, int frames) { e->counter -= frames; }
 
-void check_state_and_recurse(int best_so_far, objects_t *inputstate,
-                             int steps_since_last_increase, int depth,
-                             int seed_idx) {
-  auto p = steps_still_for_state(inputstate, seed_idx);
-  int length = p.first;
-  int best_seed_idx = p.second;
-  states_checked += 1;
-  if (length > best_so_far) {
-    most_frames_lasted = std::max(most_frames_lasted, length);
-    printf("new best on path = %d, states_checked = %ld, seed_idx = %d, "
-           "depth = %d, best overall is %d\n",
-           length, states_checked, best_seed_idx, depth, most_frames_lasted);
-    if (length == most_frames_lasted) {
-      printobjectstates(inputstate);
-    }
-    check_small_changes(length, inputstate, 0, depth + 1, best_seed_idx);
-    // } else if (false && steps_since_last_increase < 10) {
-    //   // Simulated Annealing: A worse point is accepted probabilistically.
-    //   // double temperature = initial_temperature / pow(2,length);
-    //   double temperature = initial_temperature / (length + 1);
-    //   double criterion =
-    //       exp((best_so_far - length) /
-    //           temperature); // got a seg fault when I used length instead of
-    //           depth
-    //   double rnd = randbetween(0.0, 1.0); // between 0 and 1
-    //   if (ticker > 0 && rnd < criterion) {
-    //     ticker--;
-    //     check_small_changes(best_so_far, inputstate,
-    //                         steps_since_last_increase + 1, depth + 1,
-    //                         best_seed_idx);
-    //   } else {
-    //     ticker++;
-    // }
-  } else if (best_so_far > 120 && length == best_so_far &&
-             steps_since_last_increase < 1) {
-    // only allow neutral moves after the first 120 frames
-    check_small_changes(best_so_far, inputstate, steps_since_last_increase + 1,
-                        depth + 1, best_seed_idx);
+int linear_frames(const thwomp_t &th) {
+  if (th.state == 0) { // going up
+    return std::max(0, (6607 - th.height + 9) / 10 - 1);
+  } else if (th.state == 2) { // falling, count the frames above 6192
+    long long j = first_positive_quadratic(2, 2 - th.verticalSpeed,
+                                           6192 - th.height + 1);
+    return (int)std::min(j - 1, (long long)never);
+  } else if (th.state == 3) {
+    return std::max(0, 10 - th.counter);
+  }
+  // waiting at the top or the bottom
+  return th.counter == 0 ? calls_rng_next
+                         : std::max(0, th.max - th.counter + 1);
+}
+void skip_linear(thwomp_t *th, int frames) {
+  if (th->state == 0) {
+    th->height += 10 * frames;
+  } else if (th->state == 2) {
+    th->height += frames * th->verticalSpeed - 2 * frames * (frames + 1);
+    th->verticalSpeed -= 4 * frames;
   }
+  th->counter += frames;
 }
 
-template <class T>
-void all_small_changes_to_field(T *field, int start, int end, int mul_factor,
-                                int add_factor, int best_so_far,
-                                objects_t *inputstate,
-                                int steps_since_last_increase, int depth,
-                                int seed_idx) {
-  for (int i = start; i <= end; i++) {
-    int val = i * mul_factor + add_factor;
-    if (val == *field) {
+int linear_frames(const bobomb_t &b) {
+  if (b.blinkingTimer == 0) {
+    return calls_rng_next;
+  }
+  return b.blinkingTimer < 16 ? 16 - b.blinkingTimer : 0;
+}
+void skip_linear(bobomb_t *b, int frames) {
+  b->blinkingTimer = (b->blinkingTimer + frames) % 16;
+}
+
+/* the number of frames before the object calls rng, never if it won't */
+template <typename T, void (*step)(T *, unsigned short *)>
+int frames_until_rng_call(T object) {
+  int frames = 0;
+  while (frames < never) {
+    if (never_calls_rng(object)) {
+      return never;
+    }
+    int linear = linear_frames(object);
+    if (linear == calls_rng_next) {
+      return frames;
+    } else if (linear >= never - frames) {
+      return never;
+    } else if (linear > 0) {
+      skip_linear(&object, linear);
+      frames += linear;
       continue;
     }
-    auto saved_val = *field;
-    *field = val;
-    check_state_and_recurse(best_so_far, inputstate, steps_since_last_increase,
-                            depth, seed_idx);
-    *field = saved_val;
+    unsigned short rng = 0;
+    step(&object, &rng);
+    if (rng != 0) {
+      return frames;
+    }
+    frames++;
   }
+  return never;
 }
 
-void check_small_changes(int best_so_far, objects_t *inputstate,
-                         int steps_since_last_increase, int depth,
-                         int seed_idx) {
-  inputstate->rcpscog.currentAngularVelocity = 0;
-  inputstate->rcpscog.targetAngularVelocity = 0;
+/* moves the object forward that many frames, none of which may call rng */
+template <typename T, void (*step)(T *, unsigned short *)>
+void skip_frames(T *object, int frames) {
+  while (frames > 0) {
+    int linear = std::min(linear_frames(*object), frames);
+    if (linear > 0) {
+      skip_linear(object, linear);
+      frames -= linear;
+    } else {
+      unsigned short rng = 0;
+      step(object, &rng);
+      frames--;
+    }
+  }
+}
+
+/* one entry per object in advanceobjects order */
+typedef struct event_object_t {
+  size_t offset; // of the object in objects_t
+  int (*frames_until_rng_call)(const void *object);
+  void (*skip_frames)(void *object, int frames);
+  void (*step)(void *object, unsigned short *rngValue);
+} event_object_t;
+
+template <typename T, void (*step)(T *, unsigned short *)>
+event_object_t make_event_object(size_t offset) {
+  return {offset,
+          [](const void *object) {
+            return frames_until_rng_call<T, step>(*(const T *)object);
+          },
+          [](void *object, int frames) {
+            skip_frames<T, step>((T *)object, frames);
+          },
+          [](void *object, unsigned short *rngValue) {
+            step((T *)object, rngValue);
+          }};
+}
+
+const int num_event_objects = 61;
+// the objects up to and including rcpscog, the rest stop whenever rcpscog has
+// moved too much
+const int num_early_event_objects = 26;
+
+std::array<event_object_t, num_event_objects> make_event_objects() {
+  std::array<event_object_t, num_event_objects> table;
+  int n = 0;
+  auto add = [&](event_object_t object, size_t size, int count) {
+    for (int i = 0; i < count; i++) {
+      table[n] = object;
+      table[n++].offset += i * size;
+    }
+  };
+#define EVENT_OBJECTS(field, type, function, count)                            \
+  add(make_event_object<type, function>(offsetof(objects_t, field)),           \
+      sizeof(type), count)
+  EVENT_OBJECTS(rotating_blocks, rotatingblock_t, rotatingblock, 6);
+  EVENT_OBJECTS(rotatingtriangularprisms, rotatingtriangularprism_t,
+                rotatingtriangularprism, 2);
+  EVENT_OBJECTS(pendulums, pendulum_t, pendulum, 4);
+  EVENT_OBJECTS(treadmill, treadmill_t, treadmill, 1);
+  EVENT_OBJECTS(pushers, pusher_t, pusher, 12);
+  EVENT_OBJECTS(rcpscog, rcpscog_t, rcpscog, 1);
+  EVENT_OBJECTS(cogs, cog_t, cog, 4);
+  EVENT_OBJECTS(spinningtriangles, spinningtriangle_t, spinningtriangle, 2);
+  EVENT_OBJECTS(pitblock, pitblock_t, pitblock, 1);
+  EVENT_OBJECTS(hands, hand_t, hand, 2);
+  EVENT_OBJECTS(spinners, spinner_t, spinner, 14);
+  EVENT_OBJECTS(wheels, wheel_t, wheel, 6);
+  EVENT_OBJECTS(elevators, elevator_t, elevator, 2);
+  EVENT_OBJECTS(sixthcog, cog_t, cog, 1);
+  EVENT_OBJECTS(thwomp, thwomp_t, thwomp, 1);
+  EVENT_OBJECTS(bobombs, bobomb_t, bobomb, 2);
+#undef EVENT_OBJECTS
+  return table;
+}
+
+const std::array<event_object_t, num_event_objects> event_objects =
+    make_event_objects();
+
+// a power of two, events further ahead than this wait in their slot for as
+// many laps as it takes
+const int event_wheel_size = 256;
+
+typedef struct event_sim_t {
+  // every object as it was synced_at frames into its own clock, the rng value
+  // is always current
+  objects_t objects;
+  int frame = 0;      // clock of the objects up to rcpscog
+  int late_frame = 0; // clock of the objects after it
+  std::array<int, num_event_objects> synced_at = {};
+  std::array<int, num_event_objects> next_call = {};
+  // timing wheels for the two clocks, bit i of a slot is set when object i
+  // calls rng on a frame that falls in that slot
+  std::array<uint64_t, event_wheel_size> early_wheel = {};
+  std::array<uint64_t, event_wheel_size> late_wheel = {};
+} event_sim_t;
+
+inline void *event_object_state(event_sim_t *sim, int i) {
+  return (char *)&sim->objects + event_objects[i].offset;
+}
+
+inline int event_object_clock(const event_sim_t *sim, int i) {
+  return i < num_early_event_objects ? sim->frame : sim->late_frame;
+}
+
+inline uint64_t *event_wheel_slot(event_sim_t *sim, int i, int clock) {
+  auto &wheel =
+      i < num_early_event_objects ? sim->early_wheel : sim->late_wheel;
+  return &wheel[clock & (event_wheel_size - 1)];
+}
+
+/* puts object i, synced to clock, on the wheel at its next rng call */
+inline void event_sim_schedule(event_sim_t *sim, int i, int clock) {
+  int frames =
+      event_objects[i].frames_until_rng_call(event_object_state(sim, i));
+  sim->next_call[i] = clock + frames;
+  if (frames < never) {
+    *event_wheel_slot(sim, i, sim->next_call[i]) |= 1ULL << i;
+  }
+}
+
+void event_sim_start(event_sim_t *sim, const objects_t &objects) {
+  sim->objects = objects;
+  sim->frame = 0;
+  sim->late_frame = 0;
+  sim->early_wheel.fill(0);
+  sim->late_wheel.fill(0);
+  for (int i = 0; i < num_event_objects; i++) {
+    sim->synced_at[i] = 0;
+    event_sim_schedule(sim, i, 0);
+  }
+}
+
+/* brings one object up to the current frame */
+void event_sim_sync_object(event_sim_t *sim, int i) {
+  int clock = event_object_clock(sim, i);
+  event_objects[i].skip_frames(event_object_state(sim, i),
+                               clock - sim->synced_at[i]);
+  sim->synced_at[i] = clock;
+}
+
+/* runs the objects in the slot that call rng at clock, in advanceobjects
+order since that is bit order */
+inline void event_sim_run_due(event_sim_t *sim, uint64_t *slot, int clock) {
+  uint64_t candidates = *slot;
+  while (candidates) {
+    int i = __builtin_ctzll(candidates);
+    candidates &= candidates - 1;
+    if (sim->next_call[i] != clock) { // a later lap
+      continue;
+    }
+    *slot &= ~(1ULL << i);
+    void *object = event_object_state(sim, i);
+    event_objects[i].skip_frames(object, clock - sim->synced_at[i]);
+    event_objects[i].step(object, &sim->objects.rngValue);
+    sim->synced_at[i] = clock + 1;
+    event_sim_schedule(sim, i, clock + 1);
+  }
+}
+
+/* same as calling advanceobjects frames times */
+void event_sim_advance(event_sim_t *sim, int frames) {
+  default_telemetry_t::count_frames(event_engine, frames);
+  for (; frames > 0; frames--) {
+    uint64_t *early =
+        &sim->early_wheel[sim->frame++ & (event_wheel_size - 1)];
+    if (*early) {
+      event_sim_run_due(sim, early, sim->frame - 1);
+    }
+    if (sim->objects.rcpscog.small_enough_movement_so_far == 0) {
+      continue;
+    }
+    uint64_t *late =
+        &sim->late_wheel[sim->late_frame++ & (event_wheel_size - 1)];
+    if (*late) {
+      event_sim_run_due(sim, late, sim->late_frame - 1);
+    }
+  }
+}
+
+/* Lockstep simulation of many independent objects_t at once. Every field of
+objects_t becomes a vector with one lane per candidate state (structure of
+arrays), and every object function gets a _lanes twin that computes both sides
+of each branch and picks per lane with a mask, so the whole batch advances one
+frame with the same instruction stream. RNG calls are gathers from
+rng_function_table that only advance the lanes whose branch actually polls,
+and are skipped entirely when no lane polls. The lane kernels must match the
+scalar object functions above frame for frame. */
+
+#if defined(__AVX512F__)
+const int simd_lanes = 16;
+#elif defined(__AVX2__)
+const int simd_lanes = 8;
+#else
+const int simd_lanes = 4;
+#endif
+
+typedef int32_t lane_int __attribute__((vector_size(simd_lanes * 4)));
+
+// rng_function_table with one extra entry, so a 32 bit gather of the last
+// 16 bit entry stays in bounds
+constexpr std::array<unsigned short, (1U << 16) + 2> fill_rng_gather_table() {
+  std::array<unsigned short, (1U << 16) + 2> table = {};
+  for (unsigned int i = 0; i < (1U << 16); i++) {
+    table[i] = rng_function_table[i];
+  }
+  return table;
+}
+
+constexpr std::array<unsigned short, (1U << 16) + 2> rng_gather_table =
+    fill_rng_gather_table();
+
+/* masks are lanes of all ones (true) or all zeros (false), which is what
+comparing two lane_ints gives back */
+inline lane_int choose(lane_int mask, lane_int if_true, lane_int if_false) {
+  return (if_true & mask) | (if_false & ~mask);
+}
+
+inline lane_int min_lanes(lane_int a, lane_int b) {
+  return choose(a < b, a, b);
+}
+
+inline lane_int max_lanes(lane_int a, lane_int b) {
+  return choose(a > b, a, b);
+}
+
+inline bool any_lane(lane_int mask) {
+#if defined(__AVX512F__)
+  return _mm512_test_epi32_mask((__m512i)mask, (__m512i)mask) != 0;
+#elif defined(__AVX2__)
+  return !_mm256_testz_si256((__m256i)mask, (__m256i)mask);
+#else
+  for (int lane = 0; lane < simd_lanes; lane++) {
+    if (mask[lane]) {
+      return true;
+    }
+  }
+  return false;
+#endif
+}
+
+inline int count_lanes(lane_int mask) {
+  int count = 0;
+  for (int lane = 0; lane < simd_lanes; lane++) {
+    count += mask[lane] != 0;
+  }
+  return count;
+}
+
+/* table[index] for each lane, the table has to be readable for one entry past
+the largest index because every lane loads 32 bits */
+inline lane_int gather_u16(const unsigned short *table, lane_int index) {
+#if defined(__AVX512F__)
+  // the masked form with an explicit source avoids gcc's uninitialized
+  // warning for the plain one
+  return (lane_int)_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF,
+                                               (__m512i)index, table, 2) &
+         0xFFFF;
+#elif defined(__AVX2__)
+  return (lane_int)_mm256_i32gather_epi32((const int *)table, (__m256i)index,
+                                          2) &
+         0xFFFF;
+#else
+  lane_int values;
+  for (int lane = 0; lane < simd_lanes; lane++) {
+    values[lane] = table[index[lane]];
+  }
+  return values;
+#endif
+}
+
+inline lane_int gather_i32(const int *table, lane_int index) {
+#if defined(__AVX512F__)
+  return (lane_int)_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF,
+                                               (__m512i)index, table, 4);
+#elif defined(__AVX2__)
+  return (lane_int)_mm256_i32gather_epi32(table, (__m256i)index, 4);
+#else
+  lane_int values;
+  for (int lane = 0; lane < simd_lanes; lane++) {
+    values[lane] = table[index[lane]];
+  }
+  return values;
+#endif
+}
+
+inline lane_int gather_rng(lane_int rng) {
+  return gather_u16(rng_gather_table.data(), rng);
+}
+
+/* calls and updates the rng value in the lanes set in mask */
+inline lane_int pollRNG_lanes(lane_int *rngValue, lane_int mask) {
+  if (any_lane(mask)) {
+    *rngValue = choose(mask, gather_rng(*rngValue), *rngValue);
+  }
+  return *rngValue;
+}
+
+/* same as calling pollRNG_lanes the given number of times, through the rng
+index when every polling lane is on the cycle */
+inline lane_int advanceRNG_lanes(lane_int *rngValue, lane_int mask,
+                                 int calls) {
+  if (!any_lane(mask)) {
+    return *rngValue;
+  }
+  lane_int rng_index = gather_i32(rng_value_to_index.data(), *rngValue);
+  if (any_lane(mask & (rng_index < 0))) {
+    for (int i = 0; i < calls; i++) {
+      pollRNG_lanes(rngValue, mask);
+    }
+    return *rngValue;
+  }
+  rng_index += calls % rng_cycle_length;
+  rng_index -= (rng_index >= rng_cycle_length) & rng_cycle_length;
+  *rngValue = choose(mask, gather_u16(rng_index_to_value.data(), rng_index),
+                     *rngValue);
+  return *rngValue;
+}
+
+// (((angle % 65536) + 65536) % 65536) is just the low 16 bits
+inline lane_int normalize_lanes(lane_int angle) { return angle & 0xFFFF; }
+
+inline lane_int moveNumberTowards_lanes(lane_int currentNumber,
+                                        lane_int targetNumber,
+                                        int maxDisplacement) {
+  return choose(currentNumber < targetNumber,
+                currentNumber +
+                    min_lanes(targetNumber - currentNumber,
+                              lane_int{} + maxDisplacement),
+                choose(currentNumber > targetNumber,
+                       currentNumber -
+                           min_lanes(currentNumber - targetNumber,
+                                     lane_int{} + maxDisplacement),
+                       currentNumber));
+}
+
+inline lane_int moveAngleTowards_lanes(lane_int currentAngle,
+                                       lane_int targetAngle,
+                                       int maxDisplacement) {
+  lane_int diff = targetAngle - currentAngle + 65536;
+  // C's % keeps the sign of the dividend
+  lane_int low_bits = diff & 0xFFFF;
+  diff = choose((diff < 0) & (low_bits != 0), low_bits - 65536, low_bits);
+  lane_int newAngle =
+      choose(diff < 32768,
+             currentAngle + min_lanes(diff, lane_int{} + maxDisplacement),
+             currentAngle -
+                 min_lanes(65536 - diff, lane_int{} + maxDisplacement));
+  return choose(currentAngle == targetAngle, currentAngle,
+                normalize_lanes(newAngle));
+}
+
+typedef struct bobomb_lanes_t {
+  lane_int blinkingTimer;
+} bobomb_lanes_t;
+
+void bobomb_lanes(bobomb_lanes_t *b, lane_int *rngValue, lane_int mask) {
+  lane_int blinking = b->blinkingTimer > 0;
+  lane_int rng = pollRNG_lanes(rngValue, mask & ~blinking);
+  lane_int next =
+      choose(blinking, (b->blinkingTimer + 1) & 15,
+                   choose(rng <= 655, b->blinkingTimer + 1,
+                                b->blinkingTimer));
+  b->blinkingTimer = choose(mask, next, b->blinkingTimer);
+}
+
+typedef struct cog_lanes_t {
+  lane_int currentAngularVelocity;
+  lane_int targetAngularVelocity;
+  lane_int last_target;
+  lane_int small_enough_movement_so_far;
+} cog_lanes_t;
+
+inline lane_int cog_velocity_step_lanes(lane_int current, lane_int target) {
+  return choose(current > target, current - 50,
+                choose(current < target, current + 50, current));
+}
+
+void cog_lanes(cog_lanes_t *c, lane_int *rngValue, lane_int mask) {
+  c->currentAngularVelocity = choose(
+      mask,
+      cog_velocity_step_lanes(c->currentAngularVelocity,
+                              c->targetAngularVelocity),
+      c->currentAngularVelocity);
+  lane_int reached =
+      mask & (c->currentAngularVelocity == c->targetAngularVelocity);
+  lane_int magnitude = (pollRNG_lanes(rngValue, reached) % 7) * 200;
+  lane_int sign = choose(pollRNG_lanes(rngValue, reached) <= 32766,
+                         lane_int{} - 1, lane_int{} + 1);
+  c->targetAngularVelocity =
+      choose(reached, magnitude * sign, c->targetAngularVelocity);
+}
+
+void rcpscog_lanes(cog_lanes_t *c, lane_int *rngValue, lane_int mask) {
+  c->currentAngularVelocity = choose(
+      mask,
+      cog_velocity_step_lanes(c->currentAngularVelocity,
+                              c->targetAngularVelocity),
+      c->currentAngularVelocity);
+  lane_int reached =
+      mask & (c->currentAngularVelocity == c->targetAngularVelocity);
+  lane_int magnitude = (pollRNG_lanes(rngValue, reached) % 7) * 200;
+  lane_int too_big = reached & (magnitude > 200);
+  c->small_enough_movement_so_far =
+      choose(too_big, lane_int{}, c->small_enough_movement_so_far);
+  c->last_target = choose(too_big, lane_int{}, c->last_target);
+  lane_int small = reached & ~too_big;
+  lane_int sign = choose(pollRNG_lanes(rngValue, small) <= 32766,
+                         lane_int{} - 1, lane_int{} + 1);
+  c->last_target = choose(small, c->targetAngularVelocity, c->last_target);
+  c->targetAngularVelocity =
+      choose(small, magnitude * sign, c->targetAngularVelocity);
+  lane_int wrong_way = small & (c->last_target != 0) & (magnitude != 0) &
+                       (c->last_target != -c->targetAngularVelocity);
+  c->last_target = choose(wrong_way, lane_int{}, c->last_target);
+  c->small_enough_movement_so_far =
+      choose(wrong_way, lane_int{}, c->small_enough_movement_so_far);
+}
+
+typedef struct elevator_lanes_t {
+  lane_int counter;
+} elevator_lanes_t;
+
+void elevator_lanes(elevator_lanes_t *e, lane_int *rngValue, lane_int mask) {
+  lane_int done = mask & (e->counter == 0);
+  pollRNG_lanes(rngValue, done); // direction call
+  e->counter =
+      choose(done, (pollRNG_lanes(rngValue, done) % 6) * 30 + 30, e->counter);
+  e->counter = choose(mask, e->counter - 1, e->counter);
+}
+
+// hands and wheels only differ in their constants
+typedef struct hand_lanes_t {
+  lane_int angle;
+  lane_int max;
+  lane_int targetAngle;
+  lane_int displacement;
+  lane_int directionTimer;
+  lane_int timer;
+} hand_lanes_t;
+
+typedef hand_lanes_t wheel_lanes_t;
+
+// the tick direction and new max rolled when a hand or wheel ticks
+void tick_lanes(hand_lanes_t *h, lane_int *rngValue, lane_int tick,
+                int displacement) {
+  h->targetAngle =
+      choose(tick, normalize_lanes(h->targetAngle + h->displacement),
+             h->targetAngle);
+  lane_int maybe_switch = tick & (h->directionTimer == 0);
+  lane_int ccw =
+      maybe_switch & (pollRNG_lanes(rngValue, maybe_switch) % 4 == 0);
+  lane_int cw = maybe_switch & ~ccw;
+  lane_int rng = pollRNG_lanes(rngValue, maybe_switch);
+  h->displacement =
+      choose(ccw, lane_int{} + displacement,
+             choose(cw, lane_int{} - displacement, h->displacement));
+  h->directionTimer =
+      choose(ccw, (rng % 3) * 30 + 30,
+             choose(cw, (rng % 4) * 60 + 90, h->directionTimer));
+  h->max = choose(tick, (pollRNG_lanes(rngValue, tick) % 3) * 20 + 10, h->max);
+}
+
+void hand_lanes(hand_lanes_t *h, lane_int *rngValue, lane_int mask) {
+  lane_int just_started = mask & (h->max == 0);
+  h->max = choose(just_started, lane_int{} + 10, h->max);
+  h->displacement = choose(just_started, lane_int{} - 1092, h->displacement);
+  h->angle = choose(mask, moveAngleTowards_lanes(h->angle, h->targetAngle, 200),
+                    h->angle);
+  h->directionTimer = choose(
+      mask, max_lanes(lane_int{}, h->directionTimer - 1), h->directionTimer);
+  lane_int tick = mask & (h->timer > h->max) & (h->angle == h->targetAngle);
+  tick_lanes(h, rngValue, tick, 1092);
+  h->timer = choose(tick, lane_int{}, h->timer);
+  h->timer = choose(mask, h->timer + 1, h->timer);
+}
+
+void wheel_lanes(wheel_lanes_t *w, lane_int *rngValue, lane_int mask) {
+  lane_int just_started = mask & (w->max == 0);
+  w->max = choose(just_started, lane_int{} + 5, w->max);
+  w->displacement = choose(just_started, lane_int{} - 3276, w->displacement);
+  w->angle = choose(mask, moveAngleTowards_lanes(w->angle, w->targetAngle, 200),
+                    w->angle);
+  w->directionTimer = choose(
+      mask, max_lanes(lane_int{}, w->directionTimer - 1), w->directionTimer);
+  lane_int tick = mask & (w->timer > w->max) & (w->angle == w->targetAngle);
+  tick_lanes(w, rngValue, tick, 3276);
+  w->timer = choose(tick, lane_int{}, w->timer);
+  w->timer = choose(mask, w->timer + 1, w->timer);
+}
+
+typedef struct pendulum_lanes_t {
+  lane_int accelerationDirection;
+  lane_int angle;
+  lane_int angularVelocity;
+  lane_int accelerationMagnitude;
+  lane_int waitingTimer;
+} pendulum_lanes_t;
+
+void pendulum_lanes(pendulum_lanes_t *p, lane_int *rngValue, lane_int mask) {
+  lane_int waiting = p->waitingTimer > 0;
+  lane_int swinging = mask & ~waiting;
+  p->waitingTimer =
+      choose(mask & waiting, p->waitingTimer - 1, p->waitingTimer);
+  p->accelerationMagnitude =
+      choose(swinging & (p->accelerationMagnitude == 0), lane_int{} + 13,
+             p->accelerationMagnitude);
+  p->accelerationDirection =
+      choose(swinging & (p->angle > 0), lane_int{} - 1,
+             choose(swinging & (p->angle < 0), lane_int{} + 1,
+                    p->accelerationDirection));
+  p->angularVelocity =
+      choose(swinging,
+             p->angularVelocity +
+                 p->accelerationDirection * p->accelerationMagnitude,
+             p->angularVelocity);
+  p->angle = choose(swinging, p->angle + p->angularVelocity, p->angle);
+  lane_int peak = swinging & (p->angularVelocity == 0);
+  p->accelerationMagnitude =
+      choose(peak,
+             choose(pollRNG_lanes(rngValue, peak) % 3 == 0, lane_int{} + 42,
+                    lane_int{} + 13),
+             p->accelerationMagnitude);
+  lane_int stop = peak & (pollRNG_lanes(rngValue, peak) % 2 == 0);
+  // (int)(rng / 65536.0 * 30 + 5) without the doubles
+  p->waitingTimer = choose(
+      stop, ((pollRNG_lanes(rngValue, stop) * 30) >> 16) + 5, p->waitingTimer);
+}
+
+typedef struct pitblock_lanes_t {
+  lane_int height;
+  lane_int verticalSpeed;
+  lane_int state;
+  lane_int max;
+  lane_int counter;
+} pitblock_lanes_t;
+
+void pitblock_lanes(pitblock_lanes_t *p, lane_int *rngValue, lane_int mask) {
+  lane_int moving = mask & (p->counter > p->max);
+  lane_int up = moving & (p->state == 0);
+  lane_int down = moving & ~up;
+  lane_int moved = p->height + p->verticalSpeed;
+  lane_int height = choose(up, min_lanes(lane_int{} - 71, moved),
+                           max_lanes(lane_int{} - 71, moved));
+  p->height = choose(moving, height, p->height);
+  lane_int at_end = moving & ((p->height == -71) | (p->height == 259));
+  lane_int top = up & at_end;
+  lane_int bottom = down & at_end;
+  p->verticalSpeed =
+      choose(top, lane_int{} - 9,
+             choose(bottom, lane_int{} + 11, p->verticalSpeed));
+  p->state = choose(top, lane_int{} + 1, choose(bottom, lane_int{}, p->state));
+  p->counter = choose(at_end, lane_int{}, p->counter);
+  p->max = choose(top, (pollRNG_lanes(rngValue, top) % 6) * 20 + 10,
+                  choose(bottom, lane_int{} + 20, p->max));
+  p->counter = choose(mask, p->counter + 1, p->counter);
+}
+
+typedef struct pusher_lanes_t {
+  lane_int max_index;
+  lane_int countdown;
+  lane_int state;
+  lane_int counter;
+} pusher_lanes_t;
+
+void pusher_lanes(pusher_lanes_t *p, lane_int *rngValue, lane_int mask) {
+  lane_int max = choose(
+      p->max_index == 0, lane_int{} + max_index_to_max[0],
+      choose(p->max_index == 1, lane_int{} + max_index_to_max[1],
+             choose(p->max_index == 2, lane_int{} + max_index_to_max[2],
+                    lane_int{} + max_index_to_max[3])));
+  lane_int flush = mask & (p->state == 0);
+  lane_int retracted = mask & (p->state == 1);
+  lane_int extending = mask & (p->state == 2);
+  lane_int retracting = mask & (p->state == 3);
+  lane_int has_countdown = p->countdown > 0;
+
+  // flush with wall
+  lane_int flush_waiting = flush & (p->counter <= max);
+  lane_int flush_counting = flush & ~flush_waiting & has_countdown;
+  lane_int flush_done = flush & ~flush_waiting & ~has_countdown;
+  // retracted
+  lane_int retracted_waiting = retracted & (p->counter < 10);
+  lane_int retracted_counting = retracted & ~retracted_waiting & has_countdown;
+  lane_int retracted_done = retracted & ~retracted_waiting & ~has_countdown;
+  // extending
+  lane_int extend_choice = extending & (p->counter == 1);
+  lane_int extend_step =
+      extending & ((p->counter == 0) | ((p->counter > 1) & (p->counter < 36)));
+  lane_int extend_done = extending & (p->counter >= 36);
+  // retracting
+  lane_int retract_step = retracting & (p->counter < 82);
+  lane_int retract_done = retracting & ~retract_step;
+
+  p->max_index = choose(flush_done, pollRNG_lanes(rngValue, flush_done) % 4,
+                        p->max_index);
+  lane_int roll_countdown =
+      flush_done & (pollRNG_lanes(rngValue, flush_done) % 2 == 0);
+  p->countdown = choose(
+      roll_countdown,
+      ((pollRNG_lanes(rngValue, roll_countdown) * 100) >> 16) + 20,
+      choose(flush_counting | retracted_counting, p->countdown - 1,
+             p->countdown));
+  lane_int fake_extend =
+      extend_choice & (pollRNG_lanes(rngValue, extend_choice) % 4 == 0);
+
+  lane_int increment = flush_waiting | flush_counting | retracted_waiting |
+                       retracted_counting | extend_step | retract_step |
+                       (extend_choice & ~fake_extend);
+  lane_int reset = flush_done | retracted_done | extend_done | retract_done |
+                   fake_extend;
+  p->counter = choose(increment, p->counter + 1,
+                      choose(reset, lane_int{}, p->counter));
+  p->state = choose(flush_done, lane_int{} + 1,
+                    choose(retracted_done, lane_int{} + 2,
+                           choose(extend_done, lane_int{} + 3,
+                                  choose(retract_done | fake_extend,
+                                         lane_int{}, p->state))));
+}
+
+typedef struct rotatingblock_lanes_t {
+  lane_int remaining_time;
+} rotatingblock_lanes_t;
+
+void rotatingblock_lanes(rotatingblock_lanes_t *rb, lane_int *rngValue,
+                         lane_int mask) {
+  lane_int done = mask & (rb->remaining_time == 0);
+  rb->remaining_time =
+      choose(done, (pollRNG_lanes(rngValue, done) % 7) * 20 + 45,
+             rb->remaining_time);
+  rb->remaining_time =
+      choose(mask, rb->remaining_time - 1, rb->remaining_time);
+}
+
+typedef struct rotatingtriangularprism_lanes_t {
+  lane_int max;
+  lane_int timer;
+} rotatingtriangularprism_lanes_t;
+
+void rotatingtriangularprism_lanes(rotatingtriangularprism_lanes_t *rtp,
+                                   lane_int *rngValue, lane_int mask) {
+  lane_int done = mask & (rtp->timer >= rtp->max + 45);
+  rtp->max =
+      choose(done, (pollRNG_lanes(rngValue, done) % 7) * 20 + 5, rtp->max);
+  rtp->timer = choose(done, lane_int{}, rtp->timer);
+  rtp->timer = choose(mask, rtp->timer + 1, rtp->timer);
+}
+
+typedef struct spinner_lanes_t {
+  lane_int max;
+  lane_int counter;
+} spinner_lanes_t;
+
+void spinner_lanes(spinner_lanes_t *sp, lane_int *rngValue, lane_int mask) {
+  lane_int done = mask & (sp->counter > sp->max);
+  pollRNG_lanes(rngValue, done); // for direction
+  sp->max =
+      choose(done, (pollRNG_lanes(rngValue, done) % 4) * 30 + 30, sp->max);
+  sp->counter = choose(done, lane_int{}, sp->counter);
+  sp->counter = choose(mask, sp->counter + 1, sp->counter);
+}
+
+// a spinning triangle is just a cog
+typedef struct spinningtriangle_lanes_t {
+  lane_int currentAngularVelocity;
+  lane_int targetAngularVelocity;
+} spinningtriangle_lanes_t;
+
+void spinningtriangle_lanes(spinningtriangle_lanes_t *st, lane_int *rngValue,
+                            lane_int mask) {
+  st->currentAngularVelocity = choose(
+      mask,
+      cog_velocity_step_lanes(st->currentAngularVelocity,
+                              st->targetAngularVelocity),
+      st->currentAngularVelocity);
+  lane_int reached =
+      mask & (st->currentAngularVelocity == st->targetAngularVelocity);
+  lane_int magnitude = (pollRNG_lanes(rngValue, reached) % 7) * 200;
+  lane_int sign = choose(pollRNG_lanes(rngValue, reached) <= 32766,
+                         lane_int{} - 1, lane_int{} + 1);
+  st->targetAngularVelocity =
+      choose(reached, magnitude * sign, st->targetAngularVelocity);
+}
+
+typedef struct thwomp_lanes_t {
+  lane_int height;
+  lane_int verticalSpeed;
+  lane_int max;
+  lane_int state;
+  lane_int counter;
+} thwomp_lanes_t;
+
+void thwomp_lanes(thwomp_lanes_t *th, lane_int *rngValue, lane_int mask) {
+  lane_int going_up = mask & (th->state == 0);
+  lane_int at_top = mask & (th->state == 1);
+  lane_int going_down = mask & (th->state == 2);
+  lane_int at_bottom = mask & (th->state == 3);
+  lane_int at_bottom_rolled = mask & (th->state == 4);
+
+  lane_int just_stopped = (at_top | at_bottom_rolled) & (th->counter == 0);
+  lane_int rng = pollRNG_lanes(rngValue, just_stopped);
+  // (int)(rng / 65536.0 * 30 + 10) and (int)(rng / 65536.0 * 10 + 20)
+  th->max = choose(at_top & just_stopped, ((rng * 30) >> 16) + 10,
+                   choose(at_bottom_rolled & just_stopped,
+                          ((rng * 10) >> 16) + 20, th->max));
+
+  th->verticalSpeed =
+      choose(going_down, th->verticalSpeed - 4, th->verticalSpeed);
+  th->height = choose(
+      going_up, min_lanes(lane_int{} + 6607, th->height + 10),
+      choose(going_down,
+             max_lanes(lane_int{} + 6192, th->height + th->verticalSpeed),
+             th->height));
+  lane_int reached_top = going_up & (th->height == 6607);
+  lane_int reached_bottom = going_down & (th->height == 6192);
+  th->verticalSpeed =
+      choose(reached_bottom, lane_int{}, th->verticalSpeed);
+
+  lane_int waiting = ((at_top | at_bottom_rolled) & (th->counter <= th->max)) |
+                     (at_bottom & (th->counter < 10));
+  lane_int done_waiting = (at_top | at_bottom | at_bottom_rolled) & ~waiting;
+  lane_int next_state = choose(
+      reached_top, lane_int{} + 1,
+      choose(reached_bottom, lane_int{} + 3, th->state + 1));
+  next_state = choose(at_bottom_rolled, lane_int{}, next_state);
+  lane_int change = reached_top | reached_bottom | done_waiting;
+  th->state = choose(change, next_state, th->state);
+  th->counter =
+      choose(change, lane_int{},
+             choose(going_up | going_down | waiting, th->counter + 1,
+                    th->counter));
+}
+
+typedef struct treadmill_lanes_t {
+  lane_int currentSpeed;
+  lane_int targetSpeed;
+  lane_int max;
+  lane_int counter;
+} treadmill_lanes_t;
+
+void treadmill_lanes(treadmill_lanes_t *tr, lane_int *rngValue,
+                     lane_int mask) {
+  lane_int moving = mask & (tr->counter <= tr->max);
+  lane_int accelerating = moving & (tr->counter > 5);
+  lane_int slowing = mask & ~moving;
+  tr->currentSpeed = choose(
+      accelerating,
+      moveNumberTowards_lanes(tr->currentSpeed, tr->targetSpeed, 10),
+      choose(slowing, moveNumberTowards_lanes(tr->currentSpeed, lane_int{}, 10),
+             tr->currentSpeed));
+  lane_int stopped = slowing & (tr->currentSpeed == 0);
+  tr->max = choose(stopped, (pollRNG_lanes(rngValue, stopped) % 7) * 20 + 10,
+                   tr->max);
+  tr->targetSpeed = choose(stopped,
+                           choose(pollRNG_lanes(rngValue, stopped) <= 32766,
+                                  lane_int{} - 50, lane_int{} + 50),
+                           tr->targetSpeed);
+  tr->counter = choose(stopped, lane_int{}, tr->counter);
+  tr->counter = choose(mask, tr->counter + 1, tr->counter);
+}
+
+typedef struct objects_lanes_t {
+  rotatingblock_lanes_t rotating_blocks[6];
+  rotatingtriangularprism_lanes_t rotatingtriangularprisms[2];
+  pendulum_lanes_t pendulums[4];
+  treadmill_lanes_t treadmill;
+  pusher_lanes_t pushers[12];
+  cog_lanes_t rcpscog;
+  cog_lanes_t cogs[4];
+  spinningtriangle_lanes_t spinningtriangles[2];
+  pitblock_lanes_t pitblock;
+  hand_lanes_t hands[2];
+  spinner_lanes_t spinners[14];
+  wheel_lanes_t wheels[6];
+  elevator_lanes_t elevators[2];
+  cog_lanes_t sixthcog;
+  thwomp_lanes_t thwomp;
+  bobomb_lanes_t bobombs[2];
+  lane_int rngValue;
+} objects_lanes_t;
+
+/* moves the lanes set in active forward one frame, exactly like calling
+advanceobjects on each of them */
+template <typename telemetry = default_telemetry_t>
+void advanceobjects_lanes(objects_lanes_t *objects, lane_int active) {
+  typedef typename telemetry::template lanes_scope_t<lane_int> scope_t;
+  lane_int *rng = &objects->rngValue;
+  int i;
+  telemetry::count_frames(lanes_engine, count_lanes(active));
+  for (i = 0; i < 6; i++) {
+    scope_t scope(rotating_block_kind, rng, active);
+    rotatingblock_lanes(&objects->rotating_blocks[i], rng, active);
+  }
+  for (i = 0; i < 2; i++) {
+    scope_t scope(rotating_triangular_prism_kind, rng, active);
+    rotatingtriangularprism_lanes(&objects->rotatingtriangularprisms[i], rng,
+                                  active);
+  }
+  for (i = 0; i < 4; i++) {
+    scope_t scope(pendulum_kind, rng, active);
+    pendulum_lanes(&objects->pendulums[i], rng, active);
+  }
+  {
+    scope_t scope(treadmill_kind, rng, active);
+    treadmill_lanes(&objects->treadmill, rng, active);
+  }
+  for (i = 0; i < 12; i++) {
+    scope_t scope(pusher_kind, rng, active);
+    pusher_lanes(&objects->pushers[i], rng, active);
+  }
+  {
+    scope_t scope(rcpscog_kind, rng, active);
+    rcpscog_lanes(&objects->rcpscog, rng, active);
+  }
+  // lanes whose cog already moved too much skip the rest, like the early
+  // return in advanceobjects
+  active &= objects->rcpscog.small_enough_movement_so_far != 0;
+  if (!any_lane(active)) {
+    return;
+  }
+  for (i = 0; i < 4; i++) {
+    scope_t scope(cog_kind, rng, active);
+    cog_lanes(&objects->cogs[i], rng, active);
+  }
+  for (i = 0; i < 2; i++) {
+    scope_t scope(spinning_triangle_kind, rng, active);
+    spinningtriangle_lanes(&objects->spinningtriangles[i], rng, active);
+  }
+  {
+    scope_t scope(pit_block_kind, rng, active);
+    pitblock_lanes(&objects->pitblock, rng, active);
+  }
+  for (i = 0; i < 2; i++) {
+    scope_t scope(hand_kind, rng, active);
+    hand_lanes(&objects->hands[i], rng, active);
+  }
+  for (i = 0; i < 14; i++) {
+    scope_t scope(spinner_kind, rng, active);
+    spinner_lanes(&objects->spinners[i], rng, active);
+  }
+  for (i = 0; i < 6; i++) {
+    scope_t scope(wheel_kind, rng, active);
+    wheel_lanes(&objects->wheels[i], rng, active);
+  }
+  for (i = 0; i < 2; i++) {
+    scope_t scope(elevator_kind, rng, active);
+    elevator_lanes(&objects->elevators[i], rng, active);
+  }
+  {
+    scope_t scope(sixth_cog_kind, rng, active);
+    cog_lanes(&objects->sixthcog, rng, active);
+  }
+  {
+    scope_t scope(thwomp_kind, rng, active);
+    thwomp_lanes(&objects->thwomp, rng, active);
+  }
+  for (i = 0; i < 2; i++) {
+    scope_t scope(bobomb_kind, rng, active);
+    bobomb_lanes(&objects->bobombs[i], rng, active);
+  }
+}
+
+/* copies one field between a scalar state and one lane of a batch, in the
+direction given by to_lanes */
+template <bool to_lanes, class T>
+inline void lane_field(lane_int &lanes, T &field, int lane) {
+  if (to_lanes) {
+    lanes[lane] = field;
+  } else {
+    field = (T)lanes[lane];
+  }
+}
+
+template <bool to_lanes>
+void copy_lane(objects_lanes_t *lanes, objects_t *state, int lane) {
+  // the rcps cog has two more fields, which stay 0 in the lanes of the others
+  auto copy_cog = [lane](cog_lanes_t &lc, auto &c) {
+    lane_field<to_lanes>(lc.currentAngularVelocity, c.currentAngularVelocity,
+                         lane);
+    lane_field<to_lanes>(lc.targetAngularVelocity, c.targetAngularVelocity,
+                         lane);
+  };
+  // hands and wheels have the same fields
+  auto copy_hand = [lane](hand_lanes_t &lh, auto &h) {
+    lane_field<to_lanes>(lh.angle, h.angle, lane);
+    lane_field<to_lanes>(lh.max, h.max, lane);
+    lane_field<to_lanes>(lh.targetAngle, h.targetAngle, lane);
+    lane_field<to_lanes>(lh.displacement, h.displacement, lane);
+    lane_field<to_lanes>(lh.directionTimer, h.directionTimer, lane);
+    lane_field<to_lanes>(lh.timer, h.timer, lane);
+  };
+  int i;
+  for (i = 0; i < 6; i++) {
+    lane_field<to_lanes>(lanes->rotating_blocks[i].remaining_time,
+                         state->rotating_blocks[i].remaining_time, lane);
+  }
+  for (i = 0; i < 2; i++) {
+    lane_field<to_lanes>(lanes->rotatingtriangularprisms[i].max,
+                         state->rotatingtriangularprisms[i].max, lane);
+    lane_field<to_lanes>(lanes->rotatingtriangularprisms[i].timer,
+                         state->rotatingtriangularprisms[i].timer, lane);
+  }
+  for (i = 0; i < 4; i++) {
+    auto &lp = lanes->pendulums[i];
+    auto &p = state->pendulums[i];
+    lane_field<to_lanes>(lp.accelerationDirection, p.accelerationDirection,
+                         lane);
+    lane_field<to_lanes>(lp.angle, p.angle, lane);
+    lane_field<to_lanes>(lp.angularVelocity, p.angularVelocity, lane);
+    lane_field<to_lanes>(lp.accelerationMagnitude, p.accelerationMagnitude,
+                         lane);
+    lane_field<to_lanes>(lp.waitingTimer, p.waitingTimer, lane);
+  }
+  lane_field<to_lanes>(lanes->treadmill.currentSpeed,
+                       state->treadmill.currentSpeed, lane);
+  lane_field<to_lanes>(lanes->treadmill.targetSpeed,
+                       state->treadmill.targetSpeed, lane);
+  lane_field<to_lanes>(lanes->treadmill.max, state->treadmill.max, lane);
+  lane_field<to_lanes>(lanes->treadmill.counter, state->treadmill.counter,
+                       lane);
+  for (i = 0; i < 12; i++) {
+    auto &lp = lanes->pushers[i];
+    auto &p = state->pushers[i];
+    lane_field<to_lanes>(lp.max_index, p.max_index, lane);
+    lane_field<to_lanes>(lp.countdown, p.countdown, lane);
+    lane_field<to_lanes>(lp.state, p.state, lane);
+    lane_field<to_lanes>(lp.counter, p.counter, lane);
+  }
+  copy_cog(lanes->rcpscog, state->rcpscog);
+  lane_field<to_lanes>(lanes->rcpscog.last_target, state->rcpscog.last_target,
+                       lane);
+  lane_field<to_lanes>(lanes->rcpscog.small_enough_movement_so_far,
+                       state->rcpscog.small_enough_movement_so_far, lane);
+  for (i = 0; i < 4; i++) {
+    copy_cog(lanes->cogs[i], state->cogs[i]);
+  }
+  for (i = 0; i < 2; i++) {
+    lane_field<to_lanes>(lanes->spinningtriangles[i].currentAngularVelocity,
+                         state->spinningtriangles[i].currentAngularVelocity,
+                         lane);
+    lane_field<to_lanes>(lanes->spinningtriangles[i].targetAngularVelocity,
+                         state->spinningtriangles[i].targetAngularVelocity,
+                         lane);
+  }
+  lane_field<to_lanes>(lanes->pitblock.height, state->pitblock.height, lane);
+  lane_field<to_lanes>(lanes->pitblock.verticalSpeed,
+                       state->pitblock.verticalSpeed, lane);
+  lane_field<to_lanes>(lanes->pitblock.state, state->pitblock.state, lane);
+  lane_field<to_lanes>(lanes->pitblock.max, state->pitblock.max, lane);
+  lane_field<to_lanes>(lanes->pitblock.counter, state->pitblock.counter, lane);
+  for (i = 0; i < 2; i++) {
+    copy_hand(lanes->hands[i], state->hands[i]);
+  }
+  for (i = 0; i < 14; i++) {
+    lane_field<to_lanes>(lanes->spinners[i].max, state->spinners[i].max, lane);
+    lane_field<to_lanes>(lanes->spinners[i].counter,
+                         state->spinners[i].counter, lane);
+  }
+  for (i = 0; i < 6; i++) {
+    copy_hand(lanes->wheels[i], state->wheels[i]);
+  }
+  for (i = 0; i < 2; i++) {
+    lane_field<to_lanes>(lanes->elevators[i].counter,
+                         state->elevators[i].counter, lane);
+  }
+  copy_cog(lanes->sixthcog, state->sixthcog);
+  lane_field<to_lanes>(lanes->thwomp.height, state->thwomp.height, lane);
+  lane_field<to_lanes>(lanes->thwomp.verticalSpeed,
+                       state->thwomp.verticalSpeed, lane);
+  lane_field<to_lanes>(lanes->thwomp.max, state->thwomp.max, lane);
+  lane_field<to_lanes>(lanes->thwomp.state, state->thwomp.state, lane);
+  lane_field<to_lanes>(lanes->thwomp.counter, state->thwomp.counter, lane);
+  for (i = 0; i < 2; i++) {
+    lane_field<to_lanes>(lanes->bobombs[i].blinkingTimer,
+                         state->bobombs[i].blinkingTimer, lane);
+  }
+  lane_field<to_lanes>(lanes->rngValue, state->rngValue, lane);
+}
+
+void set_lane(objects_lanes_t *lanes, int lane, objects_t state) {
+  copy_lane<true>(lanes, &state, lane);
+}
+
+objects_t get_lane(objects_lanes_t *lanes, int lane) {
+  objects_t state;
+  copy_lane<false>(lanes, &state, lane);
+  return state;
+}
+
+/* copies every lane set in mask from src to dst */
+void blend_lanes(objects_lanes_t *dst, const objects_lanes_t *src,
+                 lane_int mask) {
+  // objects_lanes_t is nothing but lane_ints
+  lane_int *to = (lane_int *)dst;
+  const lane_int *from = (const lane_int *)src;
+  for (size_t i = 0; i < sizeof(objects_lanes_t) / sizeof(lane_int); i++) {
+    to[i] = choose(mask, from[i], to[i]);
+  }
+}
+
+void randomizearray(objects_t *inputstate) {
   int a;
   for (a = 0; a < 6; a++) {
     // inputstate->rotating_blocks[a].max = randbetween<0, 6>() * 20 + 5;
-    // all_small_changes_to_field(&inputstate->rotating_blocks[a].timer, 0,
-    //                            (inputstate->rotating_blocks[a].max + 40) / 5,
-    //                            5, 0, best_so_far, inputstate,
-    //                            steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->rotating_blocks[a].remaining_time,
-                               0, 165, 1, 0, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
+    // inputstate->rotating_blocks[a].timer =
+    //     randbetween(0, ((inputstate->rotating_blocks[a].max + 40) / 5) * 5);
+    inputstate->rotating_blocks[a].remaining_time = randbetween<0, 165>();
+  }
+  for (a = 0; a < 2; a++) {
+    inputstate->rotatingtriangularprisms[a].max = randbetween<0, 6>() * 20 + 5;
+    inputstate->rotatingtriangularprisms[a].timer = randbetween(
+        0, ((inputstate->rotatingtriangularprisms[a].max + 45) / 5) * 5);
+  }
+  for (a = 0; a < 4; a++) {
+    inputstate->pendulums[a].waitingTimer = randbetween<0, 34>();
+    inputstate->pendulums[a].accelerationDirection =
+        randbetween<0, 1>() * 2 - 1;
+    inputstate->pendulums[a].angle = randbetween<0, 1000>() * 13 - 6500;
+    inputstate->pendulums[a].angularVelocity = randbetween<1, 5>() * 21 - 63;
+    inputstate->pendulums[a].accelerationMagnitude =
+        randbetween<0, 1>() * 29 + 13;
+  }
+  inputstate->treadmill.currentSpeed = randbetween<-5, 5>() * 10;
+  inputstate->treadmill.targetSpeed = randbetween<0, 1>() * 100 - 50;
+  inputstate->treadmill.max = randbetween<0, 6>() * 20 + 10;
+  inputstate->treadmill.counter =
+      randbetween(0, ((inputstate->treadmill.max) / 5) * 5);
+  for (a = 0; a < 12; a++) {
+    inputstate->pushers[a].max_index = randbetween<0, 3>();
+    inputstate->pushers[a].countdown = randbetween<0, 119>();
+    inputstate->pushers[a].state = randbetween<0, 3>();
+    inputstate->pushers[a].counter = randbetween(
+        0, ((max_index_to_max[inputstate->pushers[a].max_index]) / 5) * 5);
+  }
+  inputstate->rcpscog.currentAngularVelocity = 0;
+  inputstate->rcpscog.targetAngularVelocity = 0;
+  for (a = 0; a < 4; a++) {
+    inputstate->cogs[a].currentAngularVelocity = randbetween<-24, 24>() * 50;
+    inputstate->cogs[a].targetAngularVelocity = randbetween<-6, 6>() * 20;
+  }
+  for (a = 0; a < 2; a++) {
+    inputstate->spinningtriangles[a].currentAngularVelocity =
+        randbetween<-24, 24>() * 50;
+    inputstate->spinningtriangles[a].targetAngularVelocity =
+        randbetween<-6, 6>() * 20;
+  }
+  inputstate->pitblock.height = randbetween<0, 30>() * 11 - 71;
+  inputstate->pitblock.verticalSpeed = randbetween<0, 1>() * 20 - 9;
+  inputstate->pitblock.state = randbetween<0, 1>();
+  inputstate->pitblock.max = (randbetween<0, 6>() * 20 + 9) % 110 + 1;
+  inputstate->pitblock.counter = randbetween(0, inputstate->pitblock.max);
+  for (a = 0; a < 2; a++) {
+    inputstate->hands[a].angle = randbetween<-6, 6>() * 182;
+    inputstate->hands[a].max = randbetween<0, 2>() * 20 + 10;
+    inputstate->hands[a].targetAngle = randbetween<-1, 1>() * 1092;
+    inputstate->hands[a].displacement = (randbetween<0, 1>() * 2 - 1) * 1092;
+    inputstate->hands[a].directionTimer =
+        (randbetween<0, 5>() * 60 + 29) % 270 + 1;
+    inputstate->hands[a].timer = randbetween(0, inputstate->hands[a].max);
+  }
+  for (a = 0; a < 14; a++) {
+    // inputstate->spinners[a].direction = randbetween<0, 1>() * 2 - 1;
+    inputstate->spinners[a].max = randbetween<0, 3>() * 30 + 30;
+    inputstate->spinners[a].counter =
+        randbetween(0, inputstate->spinners[a].max);
+  }
+  for (a = 0; a < 6; a++) {
+    inputstate->wheels[a].max = randbetween<0, 2>() * 20 + 10;
+    inputstate->wheels[a].angle = randbetween<-14, 14>() * 234;
+    inputstate->wheels[a].targetAngle = randbetween<-1, 1>() * 3276;
+    inputstate->wheels[a].displacement = (randbetween<0, 1>() * 2 - 1) * 3276;
+    inputstate->wheels[a].directionTimer =
+        (randbetween<0, 5>() * 60 + 29) % 270 + 1;
+    inputstate->wheels[a].timer = randbetween(0, inputstate->wheels[a].max);
+  }
+  for (a = 0; a < 2; a++) {
+    // inputstate->elevators[a].max = randbetween<1, 6>() * 30;
+    inputstate->elevators[a].counter = randbetween(0, 180);
+  }
+  inputstate->sixthcog.currentAngularVelocity = randbetween<-24, 24>() * 50;
+  inputstate->sixthcog.targetAngularVelocity = randbetween<-6, 6>() * 20;
+  inputstate->thwomp.height = randbetween<6192, 6607>();
+  inputstate->thwomp.max = randbetween<10, 39>();
+  inputstate->thwomp.counter = randbetween(0, inputstate->thwomp.max);
+  inputstate->thwomp.state = randbetween<0, 4>();
+  inputstate->thwomp.verticalSpeed = randbetween<0, 104>() * -4;
+  for (a = 0; a < 2; a++) {
+    inputstate->bobombs[a].blinkingTimer = randbetween<0, 15>();
+  }
+}
+
+void printobjectstates(const objects_t *const inputstate) {
+  int a;
+  for (a = 0; a < 6; a++) {
+    // printf("Rotating Block %i max: %i\n", a + 1,
+    //        inputstate->rotating_blocks[a].max);
+    // printf("Rotating Block %i timer: %i\n", a + 1,
+    //        inputstate->rotating_blocks[a].timer);
+    printf("Rotating Block %i remaining time: %i\n", a + 1,
+           inputstate->rotating_blocks[a].remaining_time);
+  }
+  for (a = 0; a < 2; a++) {
+    printf("Rotating Triangular Prism %i max: %i, timer: %i\n", a + 1,
+           inputstate->rotatingtriangularprisms[a].max,
+           inputstate->rotatingtriangularprisms[a].timer);
+  }
+  for (a = 0; a < 4; a++) {
+    printf("Pendulum %i waiting timer: %i, acceleration direction: %i,\
+ angle: %i, angular velocity: %i, acceleration magnitude: %i\n", a + 1,
+           inputstate->pendulums[a].waitingTimer,
+           inputstate->pendulums[a].accelerationDirection,
+           inputstate->pendulums[a].angle,
+           inputstate->pendulums[a].angularVelocity,
+           inputstate->pendulums[a].accelerationMagnitude);
+  }
+  printf("Treadmill current speed: %i, target speed: %i, max: %i, counter: %i\n",
+           inputstate->treadmill.currentSpeed,
+           inputstate->treadmill.targetSpeed,
+           inputstate->treadmill.max,
+           inputstate->treadmill.counter);
+  for (a = 0; a < 12; a++) {
+    printf("Pusher %i max: %i, countdown: %i, state: %i, counter: %i\n", a + 1,
+           max_index_to_max[inputstate->pushers[a].max_index],
+           inputstate->pushers[a].countdown,
+           inputstate->pushers[a].state,
+           inputstate->pushers[a].counter);
+  }
+  printf("RCPS Cog current angular velocity: %i, target angular velocity: %i\n",
+           inputstate->rcpscog.currentAngularVelocity,
+           inputstate->rcpscog.targetAngularVelocity);
+  for (a = 0; a < 4; a++) {
+    printf("Cog %i current angular velocity: %i, target angular velocity: %i\n",
+           a + 2,
+           inputstate->cogs[a].currentAngularVelocity,
+           inputstate->cogs[a].targetAngularVelocity);
+  }
+  for (a = 0; a < 2; a++) {
+    printf("Spinning Triangle %i current angular velocity: %i,\
+ target angular velocity: %i\n", a + 1,
+           inputstate->spinningtriangles[a].currentAngularVelocity,
+           inputstate->spinningtriangles[a].targetAngularVelocity);
+  }
+  printf("Pit Block height: %i, vertical speed: %i, state: %i, max: %i,\
+ counter: %i\n",
+           inputstate->pitblock.height,
+           inputstate->pitblock.verticalSpeed,
+           inputstate->pitblock.state,
+           inputstate->pitblock.max,
+           inputstate->pitblock.counter);
+  for (a = 0; a < 2; a++) {
+    printf("Hand %i angle: %i, max: %i, target angle: %i, displacement: %i,\
+ direction timer: %i, timer: %i\n", a + 1,
+           inputstate->hands[a].angle,
+           inputstate->hands[a].max,
+           inputstate->hands[a].targetAngle,
+           inputstate->hands[a].displacement,
+           inputstate->hands[a].directionTimer,
+           inputstate->hands[a].timer);
+  }
+  for (a = 0; a < 14; a++) {
+    // printf("Spinner %i direction: %i \n", a + 1,
+    //        inputstate->spinners[a].direction);
+    printf("Spinner %i max: %i, counter: %i\n", a + 1,
+           inputstate->spinners[a].max,
+           inputstate->spinners[a].counter);
+  }
+  for (a = 0; a < 6; a++) {
+    printf("Wheel %i max: %i, angle: %i, target angle: %i, displacement: %i,\
+ direction timer: %i, timer: %i\n", a + 1,
+           inputstate->wheels[a].max,
+           inputstate->wheels[a].angle,
+           inputstate->wheels[a].targetAngle,
+           inputstate->wheels[a].displacement,
+           inputstate->wheels[a].directionTimer,
+           inputstate->wheels[a].timer);
+  }
+  for (a = 0; a < 2; a++) {
+    // printf("Elevator %i max: %i \n", a + 1, inputstate->elevators[a].max);
+    printf("Elevator %i counter: %i\n", a + 1,
+           inputstate->elevators[a].counter);
+  }
+  printf("Cog 6 current angular velocity: %i, target angular velocity: %i\n",
+         inputstate->sixthcog.currentAngularVelocity,
+         inputstate->sixthcog.targetAngularVelocity);
+  printf("Thwomp height: %i, max: %i, counter: %i, state: %i, vertical speed: %i\n",
+           inputstate->thwomp.height,
+           inputstate->thwomp.max,
+           inputstate->thwomp.counter,
+           inputstate->thwomp.state,
+           inputstate->thwomp.verticalSpeed);
+  for (a = 0; a < 2; a++) {
+    printf("Bobomb %i blinking timer: %i\n", a + 1,
+           inputstate->bobombs[a].blinkingTimer);
+  }
+  printf("RNGvalue: %i\n", inputstate->rngValue);
+}
+
+// every seed is an rng index, the value it starts from is
+// rng_index_to_value[seed_idx]
+const int num_seeds = rng_cycle_length;
+
+// runs the seeds from start up to end on the lane kernel, refilling a lane with
+// the next seed as soon as the cog moves too much in it, and writes how long
+// each one lasted to length_per_seed[seed_idx] if it isn't null
+std::pair<int, int> sweep_seeds(const objects_t &starting_state, int start,
+                                int end, int *length_per_seed) {
+  stat_timer_scope_t timer(time_simulating);
+  stat_add(count_states_evaluated, std::max(end - start, 0));
+  uint64_t frames_simulated = 0;
+  int max_still = 0;
+  int seed_idx_for_max_still = 0;
+  objects_lanes_t fresh;
+  for (int lane = 0; lane < simd_lanes; lane++) {
+    set_lane(&fresh, lane, starting_state);
+  }
+  objects_lanes_t states = fresh;
+  int lane_seed_idx[simd_lanes];
+  lane_int active = {};
+  lane_int frames = {};
+  int next_seed = start;
+  while (true) {
+    lane_int refill = {};
+    for (int lane = 0; lane < simd_lanes && next_seed < end; lane++) {
+      if (!active[lane]) {
+        refill[lane] = -1;
+        lane_seed_idx[lane] = next_seed;
+        fresh.rngValue[lane] = rng_index_to_value[next_seed++];
+      }
+    }
+    blend_lanes(&states, &fresh, refill);
+    frames = choose(refill, lane_int{}, frames);
+    active |= refill;
+    if (!any_lane(active)) {
+      break;
+    }
+    advanceobjects_lanes(&states, active);
+    frames -= active; // active lanes are -1
+    lane_int retired =
+        active & (states.rcpscog.small_enough_movement_so_far == 0);
+    if (!any_lane(retired)) {
+      continue;
+    }
+    for (int lane = 0; lane < simd_lanes; lane++) {
+      if (!retired[lane]) {
+        continue;
+      }
+      int a = frames[lane];
+      int i = lane_seed_idx[lane];
+      frames_simulated += a;
+      if (length_per_seed != nullptr) {
+        length_per_seed[i] = a;
+      }
+      // seeds finish out of order, ties go to the first seed like before
+      if (a > max_still || (a == max_still && i < seed_idx_for_max_still)) {
+        max_still = a;
+        seed_idx_for_max_still = i;
+      }
+    }
+    active &= ~retired;
+  }
+  stat_add(count_frames_simulated, frames_simulated);
+  return {max_still, seed_idx_for_max_still};
+}
+
+/* How long the cog stays still from a state for every seed, or just the ones
+near seed_idx if it is given. Returns the longest and the first seed that gets
+it. A whole sweep is split into a contiguous range of seeds per thread, and
+the ranges are merged in order so the answer doesn't depend on the threads. */
+std::pair<int, int> steps_still_for_state(objects_t *currentstartingarray,
+                                          int seed_idx = -1,
+                                          int num_threads = 1,
+                                          int *length_per_seed = nullptr) {
+  int start = 0;
+  int end = num_seeds;
+  if (seed_idx != -1) {
+    start = std::max(seed_idx - 5, 0);
+    end = std::min(num_seeds, seed_idx + 5);
+  }
+  objects_t starting_state = *currentstartingarray;
+  starting_state.rcpscog.small_enough_movement_so_far = 1;
+  num_threads = std::max(1, std::min(num_threads, (end - start) / simd_lanes));
+  if (num_threads == 1) {
+    return sweep_seeds(starting_state, start, end, length_per_seed);
+  }
+  std::vector<std::pair<int, int>> results(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      results[t] = sweep_seeds(starting_state,
+                               start + (end - start) * t / num_threads,
+                               start + (end - start) * (t + 1) / num_threads,
+                               length_per_seed);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::pair<int, int> best = results[0];
+  for (int t = 1; t < num_threads; t++) {
+    if (results[t].first > best.first) {
+      best = results[t];
+    }
+  }
+  return best;
+}
+
+// shared by every search thread when running with --threads
+std::atomic<long> states_checked{0};
+std::atomic<int> most_frames_lasted{0};
+// double initial_temperature = 0.125;
+// int ticker = 10;
+
+/* raises an atomic to at least value, returns the value it ended up at */
+int atomic_max(std::atomic<int> &target, int value) {
+  int current = target.load(std::memory_order_relaxed);
+  while (current < value &&
+         !target.compare_exchange_weak(current, value,
+                                       std::memory_order_relaxed)) {
+  }
+  return std::max(current, value);
+}
+
+// a still period can never be longer than the 1200 frames we check for
+const int max_still_frames = 1200;
+std::array<std::atomic<long>, max_still_frames + 1> found_per_length;
+
+void print_found_per_length() {
+  for (int length = 0; length <= max_still_frames; length++) {
+    long count = found_per_length[length].load(std::memory_order_relaxed);
+    if (count != 0) {
+      printf("{%d, %ld}, ", length, count);
+    }
+  }
+  printf("\n");
+}
+
+void check_small_changes(int best_so_far, objects_t *inputstate,
+                         int steps_since_last_increase, int depth = 0,
+                         int seed_idx = -1);
+
+void check_state_and_recurse(int best_so_far, objects_t *inputstate,
+                             int steps_since_last_increase, int depth,
+                             int seed_idx) {
+  auto p = steps_still_for_state(inputstate, seed_idx);
+  int length = p.first;
+  int best_seed_idx = p.second;
+  states_checked += 1;
+  if (length > best_so_far) {
+    atomic_max(most_frames_lasted, length);
+    printf("new best on path = %d, states_checked = %ld, seed_idx = %d, "
+           "depth = %d, best overall is %d\n",
+           length, states_checked.load(), best_seed_idx, depth,
+           most_frames_lasted.load());
+    if (length == most_frames_lasted) {
+      printobjectstates(inputstate);
+    }
+    check_small_changes(length, inputstate, 0, depth + 1, best_seed_idx);
+    // } else if (false && steps_since_last_increase < 10) {
+    //   // Simulated Annealing: A worse point is accepted probabilistically.
+    //   // double temperature = initial_temperature / pow(2,length);
+    //   double temperature = initial_temperature / (length + 1);
+    //   double criterion =
+    //       exp((best_so_far - length) /
+    //           temperature); // got a seg fault when I used length instead of
+    //           depth
+    //   double rnd = randbetween(0.0, 1.0); // between 0 and 1
+    //   if (ticker > 0 && rnd < criterion) {
+    //     ticker--;
+    //     check_small_changes(best_so_far, inputstate,
+    //                         steps_since_last_increase + 1, depth + 1,
+    //                         best_seed_idx);
+    //   } else {
+    //     ticker++;
+    // }
+  } else if (best_so_far > 120 && length == best_so_far &&
+             steps_since_last_increase < 1) {
+    // only allow neutral moves after the first 120 frames
+    check_small_changes(best_so_far, inputstate, steps_since_last_increase + 1,
+                        depth + 1, best_seed_idx);
+  }
+}
+
+template <class T>
+void all_small_changes_to_field(T *field, int start, int end, int mul_factor,
+                                int add_factor, int best_so_far,
+                                objects_t *inputstate,
+                                int steps_since_last_increase, int depth,
+                                int seed_idx) {
+  for (int i = start; i <= end; i++) {
+    int val = i * mul_factor + add_factor;
+    if (val == *field) {
+      continue;
+    }
+    auto saved_val = *field;
+    *field = val;
+    check_state_and_recurse(best_so_far, inputstate, steps_since_last_increase,
+                            depth, seed_idx);
+    *field = saved_val;
+  }
+}
+
+void check_small_changes(int best_so_far, objects_t *inputstate,
+                         int steps_since_last_increase, int depth,
+                         int seed_idx) {
+  inputstate->rcpscog.currentAngularVelocity = 0;
+  inputstate->rcpscog.targetAngularVelocity = 0;
+  int a;
+  for (a = 0; a < 6; a++) {
+    // inputstate->rotating_blocks[a].max = randbetween<0, 6>() * 20 + 5;
+    // all_small_changes_to_field(&inputstate->rotating_blocks[a].timer, 0,
+    //                            (inputstate->rotating_blocks[a].max + 40) / 5,
+    //                            5, 0, best_so_far, inputstate,
+    //                            steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->rotating_blocks[a].remaining_time,
+                               0, 165, 1, 0, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+  }
+  for (a = 0; a < 2; a++) {
+    // inputstate->rotatingtriangularprisms[a].max = randbetween<0, 6>() * 20
+    // + 5; inputstate->rotatingtriangularprisms[a].timer =
+    //     randbetween(0, inputstate->rotatingtriangularprisms[a].max + 45);
+    all_small_changes_to_field(
+        &inputstate->rotatingtriangularprisms[a].timer, 0,
+        (inputstate->rotatingtriangularprisms[a].max + 45) / 5, 5, 0,
+        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  }
+  for (a = 0; a < 4; a++) {
+    all_small_changes_to_field(&inputstate->pendulums[a].waitingTimer, 0, 34, 1,
+                               0, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->pendulums[a].accelerationDirection,
+                               0, 1, 2, -1, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->pendulums[a].angle, 0, 1000, 13,
+                               -6500, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->pendulums[a].angularVelocity, 1, 5,
+                               21, -63, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->pendulums[a].accelerationMagnitude,
+                               0, 1, 29, 13, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+  }
+  all_small_changes_to_field(&inputstate->treadmill.currentSpeed, -5, 5, 10, 0,
+                             best_so_far, inputstate, steps_since_last_increase,
+                             depth, seed_idx);
+  all_small_changes_to_field(&inputstate->treadmill.targetSpeed, 0, 1, 100, -50,
+                             best_so_far, inputstate, steps_since_last_increase,
+                             depth, seed_idx);
+  // inputstate->treadmill.max = randbetween<0, 6>() * 20 + 10;
+  all_small_changes_to_field(
+      &inputstate->treadmill.counter, 0, inputstate->treadmill.max / 5, 5, 0,
+      best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+
+  for (a = 0; a < 12; a++) {
+    inputstate->pushers[a].max_index = randbetween<0, 3>();
+    all_small_changes_to_field(&inputstate->pushers[a].countdown, 0, 119, 1, 0,
+                               best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->pushers[a].state, 0, 3, 1, 0,
+                               best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(
+        &inputstate->pushers[a].counter, 0,
+        max_index_to_max[inputstate->pushers[a].max_index], 1, 0, best_so_far,
+        inputstate, steps_since_last_increase, depth, seed_idx);
+  }
+
+  for (a = 0; a < 4; a++) {
+    all_small_changes_to_field(&inputstate->cogs[a].currentAngularVelocity, -24,
+                               24, 50, 0, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->cogs[a].targetAngularVelocity, -6,
+                               6, 20, 0, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+  }
+  for (a = 0; a < 2; a++) {
+    all_small_changes_to_field(
+        &inputstate->spinningtriangles[a].currentAngularVelocity, -24, 24, 50,
+        0, best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(
+        &inputstate->spinningtriangles[a].targetAngularVelocity, -6, 6, 20, 0,
+        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  }
+  all_small_changes_to_field(&inputstate->pitblock.height, 0, 30, 11, -71,
+                             best_so_far, inputstate, steps_since_last_increase,
+                             depth, seed_idx);
+  all_small_changes_to_field(&inputstate->pitblock.verticalSpeed, 0, 1, 20, -9,
+                             best_so_far, inputstate, steps_since_last_increase,
+                             depth, seed_idx);
+  all_small_changes_to_field(&inputstate->pitblock.state, 0, 1, 1, 0,
+                             best_so_far, inputstate, steps_since_last_increase,
+                             depth, seed_idx);
+  // inputstate->pitblock.max = (randbetween<0, 6>() * 20 + 9) % 110 + 1;
+  all_small_changes_to_field(
+      &inputstate->pitblock.counter, 0, inputstate->pitblock.max, 1, 0,
+      best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  for (a = 0; a < 2; a++) {
+    all_small_changes_to_field(&inputstate->hands[a].angle, -6, 6, 182, 0,
+                               best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->hands[a].targetAngle, -1, 1, 1092,
+                               0, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->hands[a].displacement, 0, 1, 2184,
+                               -1092, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    // inputstate->hands[a].directionTimer =
+    //     (randbetween<0, 5>() * 60 + 29) % 270 + 1;
+    // inputstate->hands[a].max = randbetween<0, 2>() * 20 + 10;
+    all_small_changes_to_field(
+        &inputstate->hands[a].timer, 0, inputstate->hands[a].max, 1, 0,
+        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  }
+  for (a = 0; a < 14; a++) {
+    // all_small_changes_to_field(&inputstate->spinners[a].direction, 0, 1, 2,
+    // -1,
+    //                            best_so_far, inputstate,
+    //                            steps_since_last_increase, depth, seed_idx);
+    // inputstate->spinners[a].max = randbetween<0, 3>() * 30 + 30;
+    all_small_changes_to_field(
+        &inputstate->spinners[a].counter, 0, inputstate->spinners[a].max, 1, 0,
+        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  }
+  for (a = 0; a < 6; a++) {
+    // inputstate->wheels[a].max = randbetween<0, 2>() * 20 + 10;
+    all_small_changes_to_field(&inputstate->wheels[a].angle, -14, 14, 234, 0,
+                               best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->wheels[a].targetAngle, -1, 1, 3276,
+                               0, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    all_small_changes_to_field(&inputstate->wheels[a].displacement, 0, 1,
+                               2 * 3276, -3276, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+    // inputstate->wheels[a].directionTimer =
+    //     (randbetween<0, 5>() * 60 + 29) % 270 + 1;
+    all_small_changes_to_field(
+        &inputstate->wheels[a].timer, 0, inputstate->wheels[a].max, 1, 0,
+        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  }
+  for (a = 0; a < 2; a++) {
+    // inputstate->elevators[a].max = randbetween<1, 6>() * 30;
+    all_small_changes_to_field(&inputstate->elevators[a].counter, 0, 180, 1, 0,
+                               best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+  }
+  all_small_changes_to_field(&inputstate->sixthcog.currentAngularVelocity, -24,
+                             24, 50, 0, best_so_far, inputstate,
+                             steps_since_last_increase, depth, seed_idx);
+  all_small_changes_to_field(&inputstate->sixthcog.targetAngularVelocity, -6, 6,
+                             20, 0, best_so_far, inputstate,
+                             steps_since_last_increase, depth, seed_idx);
+
+  all_small_changes_to_field(&inputstate->thwomp.height, 6192, 6607, 1, 0,
+                             best_so_far, inputstate, steps_since_last_increase,
+                             depth, seed_idx);
+  // inputstate->thwomp.max = randbetween<10, 39>();
+  all_small_changes_to_field(
+      &inputstate->thwomp.counter, 0, inputstate->thwomp.max, 1, 0, best_so_far,
+      inputstate, steps_since_last_increase, depth, seed_idx);
+  all_small_changes_to_field(&inputstate->thwomp.state, 0, 4, 1, 0, best_so_far,
+                             inputstate, steps_since_last_increase, depth,
+                             seed_idx);
+  all_small_changes_to_field(&inputstate->thwomp.verticalSpeed, 0, 104, -4, 0,
+                             best_so_far, inputstate, steps_since_last_increase,
+                             depth, seed_idx);
+  for (a = 0; a < 2; a++) {
+    all_small_changes_to_field(&inputstate->bobombs[a].blinkingTimer, 0, 15, 1,
+                               0, best_so_far, inputstate,
+                               steps_since_last_increase, depth, seed_idx);
+  }
+}
+
+// pick a random state for each search and find a new state with a small random
+// change to that state
+void runsimulation_randomstates(int num_threads) {
+  printf("Running\n");
+  stat_timer_scope_t timer(time_bookkeeping);
+  std::vector<int> length_per_seed(num_seeds);
+  // initialize_rand();
+  objects_t *currentstartingarray =
+      (objects_t *)aligned_alloc(alignof(objects_t), sizeof(objects_t));
+  memset(currentstartingarray, 0, sizeof(objects_t));
+  while (true) {
+    randomizearray(currentstartingarray);
+    auto p = steps_still_for_state(currentstartingarray, -1, num_threads,
+                                   length_per_seed.data());
+    int length = p.first;
+    int seed_idx = p.second;
+    int seeds_at_length =
+        std::count(length_per_seed.begin(), length_per_seed.end(), length);
+    atomic_max(most_frames_lasted, length);
+    states_checked += 1;
+    printf("checking top level, best so far is %d, states checked is %ld, "
+           "seed_idx = %d, %d seeds last %d\n",
+           most_frames_lasted.load(), states_checked.load(), seed_idx,
+           seeds_at_length, length);
+    check_small_changes(length, currentstartingarray, 0, 1, seed_idx);
+  }
+  free(currentstartingarray);
+}
+
+constexpr uint64_t mix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+  return x;
+}
+
+/* the longest dust vector a plan can hold, a whole plan fits in a cache line */
+const size_t max_dust_frames = 512;
+
+constexpr std::array<uint64_t, max_dust_frames> fill_dust_frame_keys() {
+  std::array<uint64_t, max_dust_frames> keys = {};
+  for (size_t i = 0; i < max_dust_frames; i++) {
+    keys[i] = mix64((i + 1) * 0x9E3779B97F4A7C15ULL);
+  }
+  return keys;
+}
+
+// a random key per frame, a plan's hash is the xor of the keys of its dust
+constexpr std::array<uint64_t, max_dust_frames> dust_frame_keys =
+    fill_dust_frame_keys();
+
+/* A dust vector packed one frame per bit, frame i is bit i % 64 of word i / 64.
+Frames past the end are always 0, so comparing two plans is comparing their
+words, and every change keeps the hash up to date, so hashing a plan costs
+nothing. */
+typedef struct dust_plan_t {
+  uint64_t words[max_dust_frames / 64] = {};
+  uint64_t hash = 0;
+  size_t frames = 0;
+
+  size_t size() const { return frames; }
+  bool empty() const { return frames == 0; }
+  bool full() const { return frames == max_dust_frames; }
+  bool operator[](size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+  bool back() const { return (*this)[frames - 1]; }
+  void flip(size_t i) {
+    words[i / 64] ^= 1ULL << (i % 64);
+    hash ^= dust_frame_keys[i];
+  }
+  void set(size_t i, bool dust) {
+    if ((*this)[i] != dust) {
+      flip(i);
+    }
+  }
+  void push_back(bool dust) {
+    frames++;
+    set(frames - 1, dust);
+  }
+  void pop_back() {
+    set(frames - 1, false);
+    frames--;
+  }
+  bool operator==(const dust_plan_t &other) const {
+    return frames == other.frames &&
+           memcmp(words, other.words, sizeof(words)) == 0;
+  }
+  // the hash doesn't see waiting frames at the end, the size does
+  uint64_t fingerprint() const {
+    return mix64(hash ^ (frames * 0x9E3779B97F4A7C15ULL));
+  }
+} dust_plan_t;
+
+void print_waiting_frames(const dust_plan_t &dust_frames) {
+  printf("\rdust vector is:");
+  for (size_t i = 0; i < dust_frames.size(); i++) {
+    if (dust_frames[i]) {
+      printf("+");
+    } else {
+      printf("-");
+    }
+  }
+}
+
+/* Prints the vector and ends the program. It can be called from any worker
+while the others are still simulating, so it doesn't exit(): that would run
+the static destructors, freeing still_lengths under them, before stdout was
+flushed. quick_exit leaves the globals alone and only runs the reports
+registered with at_quick_exit, and a second worker getting here waits on the
+lock until the process is gone. */
+void report_still_whole_time(const dust_plan_t &dust_frames) {
+  static std::mutex reporting;
+  reporting.lock();
+  printf("cog was still the whole time !!!\n");
+  print_waiting_frames(dust_frames);
+  printf("\n");
+  fflush(stdout);
+  quick_exit(0);
+}
+
+int steps_still_for_state_add_remove_dust(dust_plan_t &dust_frames,
+                                          const objects_t &states,
+                                          size_t dust_frame_to_start_with) {
+  stat_timer_scope_t timer(time_simulating);
+  stat_add(count_states_evaluated);
+  stat_add(count_frames_simulated,
+           dust_frames.size() - std::min(dust_frame_to_start_with,
+                                         dust_frames.size()));
+  event_sim_t sim;
+  event_sim_start(&sim, states);
+  const int rcpscog_index = num_early_event_objects - 1;
+  // wait some amount of frames making dust for some portion of them, the
+  // simulation only has to stop on the dust frames
+  int frames_to_dust = 0;
+  for (size_t i = dust_frame_to_start_with; i < dust_frames.size(); i++) {
+    frames_to_dust++;
+    if (dust_frames[i]) {
+      event_sim_advance(&sim, frames_to_dust);
+      advanceRNG(&sim.objects.rngValue, 4);
+      frames_to_dust = 0;
+    }
+  }
+  event_sim_advance(&sim, frames_to_dust);
+  sim.objects.rcpscog.small_enough_movement_so_far = 1;
+  // if the target is bad skip this state
+  if (sim.objects.rcpscog.targetAngularVelocity > 200 ||
+      sim.objects.rcpscog.targetAngularVelocity < -200) {
+    return 0;
+  }
+  // if the target is good, but the current is bad, wait until it is good, and
+  // then try that
+  event_sim_sync_object(&sim, rcpscog_index);
+  while (sim.objects.rcpscog.currentAngularVelocity > 200 ||
+         sim.objects.rcpscog.currentAngularVelocity < -200) {
+    if (dust_frames.full()) {
+      return 0;
+    }
+    event_sim_advance(&sim, 1);
+    event_sim_sync_object(&sim, rcpscog_index);
+    dust_frames.push_back(false);
+    stat_add(count_frames_simulated);
+  }
+
+  int a = 0;
+  for (a = 0; a < max_still_frames; a++) {
+    event_sim_advance(&sim, 1);
+    if (sim.objects.rcpscog.small_enough_movement_so_far == 0) {
+      stat_add(count_frames_simulated, a + 1);
+      return a;
+    }
+  }
+  stat_add(count_frames_simulated, a);
+
+  if (sim.objects.rcpscog.small_enough_movement_so_far == 1) {
+    report_still_whole_time(dust_frames);
+  }
+
+  return a;
+}
+
+/* hashes every field of one lane, the lanes hold no padding or scratch so equal
+states always hash the same */
+uint64_t lane_state_hash(const objects_lanes_t *states, int lane) {
+  const lane_int *fields = (const lane_int *)states;
+  uint64_t hash = 0;
+  for (size_t i = 0; i < sizeof(objects_lanes_t) / sizeof(lane_int); i++) {
+    hash = (hash ^ (uint32_t)fields[i][lane]) * 0x9E3779B97F4A7C15ULL;
+  }
+  return mix64(hash);
+}
+
+/* A lossy, lock-free table from the state at the end of the dust window to how
+long the cog stays still after it, along with how many frames it first took to
+slow down. Different dust vectors often end the window in the same state, and
+then only the first one is simulated past it. Every slot keeps key ^ data next
+to data, so a slot torn by two threads writing it at once fails the key check
+instead of giving a wrong length. New entries just overwrite old ones. */
+class transposition_table {
+public:
+  explicit transposition_table(int log2_capacity)
+      : mask((size_t(1) << log2_capacity) - 1), slots(new slot_t[mask + 1]()) {}
+
+  bool find(uint64_t key, int *length, int *slowing_frames) const {
+    const slot_t &slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ data) != key ||
+        !(data & valid)) {
+      return false;
+    }
+    *length = data & 0xFFFF;
+    *slowing_frames = (data >> 16) & 0xFFFF;
+    return true;
+  }
+
+  void store(uint64_t key, int length, int slowing_frames) {
+    slot_t &slot = slots[key & mask];
+    uint64_t data = valid | ((uint64_t)slowing_frames << 16) | length;
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+  }
+
+  void clear() {
+    for (size_t i = 0; i <= mask; i++) {
+      slots[i].check.store(0, std::memory_order_relaxed);
+      slots[i].data.store(0, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  static const uint64_t valid = 1ULL << 63;
+  typedef struct slot_t {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+  } slot_t;
+  size_t mask;
+  std::unique_ptr<slot_t[]> slots;
+};
+
+// shared by every search and thread, 16 MB
+transposition_table still_lengths(20);
+
+const size_t dust_checkpoint_interval = 16;
+
+/* Copies of the state every dust_checkpoint_interval frames into a dust
+vector, kept while its neighbours are walked. A neighbour that only changes the
+vector from some frame on is started from the last copy at or before that
+frame, so it costs the frames after the change instead of the whole window. */
+typedef struct dust_checkpoints_t {
+  objects_t states[max_dust_frames / dust_checkpoint_interval + 1];
+
+  void record(size_t frame, const objects_t &state) {
+    if (frame % dust_checkpoint_interval == 0) {
+      states[frame / dust_checkpoint_interval] = state;
+    }
+  }
+  // the frame of the last checkpoint at or before frame, it must be recorded
+  static size_t before(size_t frame) {
+    return frame / dust_checkpoint_interval * dust_checkpoint_interval;
+  }
+  // the frame of the first checkpoint at or after frame
+  static size_t after(size_t frame) {
+    return before(frame + dust_checkpoint_interval - 1);
+  }
+  const objects_t &at(size_t frame) const {
+    return states[frame / dust_checkpoint_interval];
+  }
+} dust_checkpoints_t;
+
+/* The states a dust vector goes through in its window, every
+dust_checkpoint_interval frames, and how it does when it is evaluated itself. A
+neighbour that is the same as it from some frame on, and is in the same state
+at a later checkpoint, has to end up the same way. */
+typedef struct dust_trajectory_t {
+  // the rng is compared first, it matches by chance far more often than the
+  // whole state does
+  unsigned short rng[max_dust_frames / dust_checkpoint_interval + 1];
+  uint64_t hash[max_dust_frames / dust_checkpoint_interval + 1];
+  int length;
+  int slowing_frames;
+} dust_trajectory_t;
+
+// Neighbours only look for their parent at the first few checkpoints after
+// they stop differing from it. Nearly all the ones that rejoin at all have done
+// so by then, and looking any later (or at every frame) costs more than it
+// saves, since still_lengths already catches a rejoined neighbour at the end of
+// the window, just after simulating the rest of it.
+const size_t rejoin_checkpoints = 2;
+
+/* A dust vector to try, along with the state at dust_frame_to_start_with. If
+parent is set, the vector is the same as the parent's from frame rejoin_from
+on, and the candidate stops as soon as it gets back to the parent's state. */
+typedef struct dust_candidate_t {
+  dust_plan_t dust_frames;
+  objects_t state;
+  size_t dust_frame_to_start_with;
+  int length;
+  const dust_trajectory_t *parent = nullptr;
+  size_t rejoin_from = 0;
+} dust_candidate_t;
+
+/* Finishes a candidate whose slowing frames and length are already known, from
+the table or its parent, the same way simulating them would have: if the
+waiting frames don't fit in the plan it scores 0. */
+inline void finish_with_slowing_frames(dust_candidate_t *c, int length,
+                                       int slowing_frames) {
+  if (c->dust_frames.size() + slowing_frames > max_dust_frames) {
+    c->length = 0;
+    return;
+  }
+  c->length = length;
+  for (int i = 0; i < slowing_frames; i++) {
+    c->dust_frames.push_back(false);
+  }
+}
+
+/* Does steps_still_for_state_add_remove_dust for every candidate, simd_lanes
+at a time on the lane kernel. A lane that finishes is refilled with the next
+candidate. Each length goes in candidate.length and the frames spent waiting
+for the cog to slow down are appended to candidate.dust_frames, just like the
+scalar version. A vector that keeps the cog still the whole time gets
+max_still_frames, and reporting it is left to the caller. A lane whose window
+ends in a state that is already in still_lengths finishes right there, and so
+does a lane that rejoins its parent's trajectory. */
+void steps_still_for_state_add_remove_dust_lanes(
+    dust_candidate_t *candidates, size_t count,
+    transposition_table *table = &still_lengths) {
+  stat_timer_scope_t timer(time_simulating);
+  stat_add(count_states_evaluated, count);
+  uint64_t frames_simulated = 0;
+  enum { in_dust_window, slowing_down, counting_still };
+  objects_lanes_t states = {};
+  dust_candidate_t *lane_candidate[simd_lanes];
+  int phase[simd_lanes];
+  size_t frame[simd_lanes];
+  int still[simd_lanes];
+  uint64_t window_end_hash[simd_lanes];
+  size_t window_end_size[simd_lanes];
+  size_t next_rejoin_check[simd_lanes];
+  const size_t never = std::numeric_limits<size_t>::max();
+  lane_int active = {};
+  size_t next = 0;
+
+  // gets a lane ready for its next frame, refilling it if its candidate is done
+  auto prepare_lane = [&](int lane) {
+    while (true) {
+      if (!active[lane]) {
+        if (next == count) {
+          return;
+        }
+        dust_candidate_t &c = candidates[next++];
+        set_lane(&states, lane, c.state);
+        lane_candidate[lane] = &c;
+        phase[lane] = in_dust_window;
+        frame[lane] = c.dust_frame_to_start_with;
+        next_rejoin_check[lane] =
+            c.parent == nullptr ? never
+                                : dust_checkpoints_t::after(c.rejoin_from);
+        active[lane] = -1;
+      }
+      dust_candidate_t &c = *lane_candidate[lane];
+      if (frame[lane] == next_rejoin_check[lane]) {
+        size_t checkpoint = frame[lane] / dust_checkpoint_interval;
+        next_rejoin_check[lane] += dust_checkpoint_interval;
+        if (next_rejoin_check[lane] >=
+            dust_checkpoints_t::after(c.rejoin_from) +
+                rejoin_checkpoints * dust_checkpoint_interval) {
+          next_rejoin_check[lane] = never;
+        }
+        if (frame[lane] < c.dust_frames.size() &&
+            states.rngValue[lane] == c.parent->rng[checkpoint] &&
+            lane_state_hash(&states, lane) == c.parent->hash[checkpoint]) {
+          stat_add(count_frames_skipped, c.dust_frames.size() - frame[lane] +
+                                             c.parent->slowing_frames +
+                                             c.parent->length);
+          finish_with_slowing_frames(&c, c.parent->length,
+                                     c.parent->slowing_frames);
+          active[lane] = 0;
+          continue;
+        }
+      }
+      if (phase[lane] == in_dust_window &&
+          frame[lane] >= c.dust_frames.size()) {
+        states.rcpscog.small_enough_movement_so_far[lane] = 1;
+        int target = states.rcpscog.targetAngularVelocity[lane];
+        if (target > 200 || target < -200) {
+          c.length = 0;
+          active[lane] = 0;
+          continue;
+        }
+        int slowing_frames;
+        window_end_hash[lane] = lane_state_hash(&states, lane);
+        int length;
+        if (table->find(window_end_hash[lane], &length, &slowing_frames)) {
+          stat_add(count_transposition_hits);
+          stat_add(count_frames_skipped, slowing_frames + length);
+          finish_with_slowing_frames(&c, length, slowing_frames);
+          active[lane] = 0;
+          continue;
+        }
+        stat_add(count_transposition_misses);
+        window_end_size[lane] = c.dust_frames.size();
+        phase[lane] = slowing_down;
+      }
+      if (phase[lane] == slowing_down) {
+        int current = states.rcpscog.currentAngularVelocity[lane];
+        if (current <= 200 && current >= -200) {
+          phase[lane] = counting_still;
+          still[lane] = 0;
+        }
+      }
+      return;
+    }
+  };
+
+  while (true) {
+    for (int lane = 0; lane < simd_lanes; lane++) {
+      prepare_lane(lane);
+    }
+    if (!any_lane(active)) {
+      break;
+    }
+    advanceobjects_lanes(&states, active);
+    lane_int dust = {};
+    for (int lane = 0; lane < simd_lanes; lane++) {
+      if (!active[lane]) {
+        continue;
+      }
+      frames_simulated++;
+      dust_candidate_t &c = *lane_candidate[lane];
+      if (phase[lane] == in_dust_window) {
+        dust[lane] = c.dust_frames[frame[lane]++] ? -1 : 0;
+      } else if (phase[lane] == slowing_down) {
+        if (c.dust_frames.full()) { // too long to hold, give up on it
+          c.length = 0;
+          active[lane] = 0;
+        } else {
+          c.dust_frames.push_back(false);
+        }
+      } else if (states.rcpscog.small_enough_movement_so_far[lane] == 0 ||
+                 ++still[lane] == max_still_frames) {
+        c.length = still[lane];
+        active[lane] = 0;
+        table->store(window_end_hash[lane], c.length,
+                     c.dust_frames.size() - window_end_size[lane]);
+      }
+    }
+    advanceRNG_lanes(&states.rngValue, dust, 4);
+  }
+  stat_add(count_frames_simulated, frames_simulated);
+}
+
+/* the lane kernel over a contiguous slice of the candidates per thread, if a
+thread can't be started its slice and the ones after it are done here */
+void steps_still_for_state_add_remove_dust_threaded(
+    dust_candidate_t *candidates, size_t count, int num_threads,
+    transposition_table *table = &still_lengths) {
+  if (num_threads <= 1) {
+    steps_still_for_state_add_remove_dust_lanes(candidates, count, table);
+    return;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    size_t first = count * t / num_threads;
+    size_t last = count * (t + 1) / num_threads;
+    try {
+      threads.emplace_back([candidates, first, last, table] {
+        steps_still_for_state_add_remove_dust_lanes(candidates + first,
+                                                    last - first, table);
+      });
+    } catch (const std::system_error &) {
+      steps_still_for_state_add_remove_dust_lanes(candidates + first,
+                                                  count - first, table);
+      break;
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+/* walks dust_frames to fill in its trajectory, then evaluates it */
+void trace_dust_trajectory(const dust_plan_t &dust_frames,
+                           dust_trajectory_t *trajectory) {
+  stat_timer_scope_t timer(time_simulating);
+  objects_lanes_t lanes = {};
+  objects_t state = initial_state;
+  for (size_t i = 0; i < dust_frames.size(); i++) {
+    if (i % dust_checkpoint_interval == 0) {
+      set_lane(&lanes, 0, state);
+      trajectory->rng[i / dust_checkpoint_interval] = state.rngValue;
+      trajectory->hash[i / dust_checkpoint_interval] =
+          lane_state_hash(&lanes, 0);
+    }
+    advanceobjects(&state);
+    if (dust_frames[i]) {
+      advanceRNG(&state.rngValue, 4);
+    }
+  }
+  // one vector doesn't fill the lanes, so this is the event driven version
+  dust_plan_t self = dust_frames;
+  trajectory->length =
+      steps_still_for_state_add_remove_dust(self, state, dust_frames.size());
+  trajectory->slowing_frames = self.size() - dust_frames.size();
+}
+
+// neighbours are simulated this many at a time before any of them is recursed
+// into, enough to keep every lane busy while the shorter ones get refilled
+const size_t dust_batch_size = 4 * simd_lanes;
+
+static long max_states_to_check = std::numeric_limits<int64_t>::max();
+
+/* One level of the add/remove dust search: a dust vector on the current path,
+how long it lasted, and how far through trying its neighbours the search is.
+The search keeps one level per depth and reuses them, so going deeper or
+backing up never copies the path, and once the vectors in them have grown it
+doesn't allocate either. */
+typedef struct dust_search_level_t {
+  dust_plan_t dust_frames;
+  int length;
+  uint64_t fingerprint;
+  int best_so_far;
+  int steps_since_last_increase;
+  // neighbours are tried by flipping frame i, then moving each dust frame j
+  // shortly after i to i, and after all frames adding one and removing one
+  enum { flip, move, add_dust, add_wait, remove, done } stage;
+  size_t i;
+  size_t j;
+  objects_t state; // at frame i
+  dust_checkpoints_t checkpoints; // of the frames up to i
+  dust_trajectory_t trajectory;
+  std::vector<dust_candidate_t> batch;
+  size_t batch_count;
+  size_t batch_pos;
+} dust_search_level_t;
+
+/* writes the next neighbour of the level's dust vector to candidate, false once
+there are none left */
+bool next_dust_neighbour(dust_search_level_t *level,
+                         dust_candidate_t *candidate) {
+  const dust_plan_t &dust_frames = level->dust_frames;
+  const size_t n = dust_frames.size();
+  const size_t biggest_move_size = 5;
+  while (true) {
+    switch (level->stage) {
+    case dust_search_level_t::flip:
+      level->checkpoints.record(level->i, level->state);
+      if (level->i == n) {
+        level->stage = dust_search_level_t::add_dust;
+        continue;
+      }
+      candidate->dust_frames = dust_frames;
+      candidate->dust_frames.flip(level->i);
+      candidate->state = level->state;
+      candidate->dust_frame_to_start_with = level->i;
+      candidate->parent = &level->trajectory;
+      candidate->rejoin_from = level->i + 1;
+      level->j = level->i + 1;
+      level->stage = dust_search_level_t::move;
+      return true;
+    case dust_search_level_t::move:
+      while (level->j < std::min(n, level->i + biggest_move_size)) {
+        size_t j = level->j++;
+        if (dust_frames[j] && !dust_frames[level->i]) {
+          candidate->dust_frames = dust_frames;
+          candidate->dust_frames.flip(level->i);
+          candidate->dust_frames.flip(j);
+          candidate->state = level->state;
+          candidate->dust_frame_to_start_with = level->i;
+          candidate->parent = &level->trajectory;
+          candidate->rejoin_from = j + 1;
+          return true;
+        }
+      }
+      advanceobjects(&level->state);
+      if (dust_frames[level->i]) {
+        advanceRNG(&level->state.rngValue, 4);
+      }
+      level->i++;
+      level->stage = dust_search_level_t::flip;
+      continue;
+    case dust_search_level_t::add_dust:
+    case dust_search_level_t::add_wait:
+      if (dust_frames.full()) {
+        level->stage = dust_search_level_t::remove;
+        continue;
+      }
+      candidate->dust_frames = dust_frames;
+      candidate->dust_frames.push_back(level->stage ==
+                                       dust_search_level_t::add_dust);
+      candidate->state = level->state;
+      candidate->dust_frame_to_start_with = n + 1;
+      candidate->parent = nullptr;
+      level->stage = level->stage == dust_search_level_t::add_dust
+                         ? dust_search_level_t::add_wait
+                         : dust_search_level_t::remove;
+      return true;
+    case dust_search_level_t::remove:
+      level->stage = dust_search_level_t::done;
+      if (n == 0) {
+        continue;
+      }
+      // only the last frame changes, the walk checkpointed everything before it
+      candidate->dust_frames = dust_frames;
+      candidate->dust_frames.pop_back();
+      candidate->dust_frame_to_start_with = dust_checkpoints_t::before(n - 1);
+      candidate->state =
+          level->checkpoints.at(candidate->dust_frame_to_start_with);
+      candidate->parent = nullptr;
+      return true;
+    case dust_search_level_t::done:
+      return false;
+    }
+  }
+}
+
+/* gets a level ready to go through the neighbours of dust_frames */
+void start_dust_level(dust_search_level_t *level,
+                      const dust_plan_t &dust_frames) {
+  level->dust_frames = dust_frames;
+  level->fingerprint = dust_frames.fingerprint();
+  level->stage = dust_search_level_t::flip;
+  level->i = 0;
+  level->state = initial_state;
+  trace_dust_trajectory(dust_frames, &level->trajectory);
+  level->batch_count = 0;
+  level->batch_pos = 0;
+}
+
+/* start with a dust vector and how long it lasted, then try its neighbours,
+going deeper into the ones that last longer than anything on the path so far
+(or that are only a few steps worse) */
+void search_add_remove_dust(const dust_plan_t &start_frames, int length,
+                            int bad_steps_allowed) {
+  stat_timer_scope_t timer(time_bookkeeping);
+  std::vector<dust_search_level_t> levels;
+  size_t depth = 0;
+  auto enter_level = [&](size_t at, const dust_plan_t &dust_frames,
+                         int length, int best_so_far,
+                         int steps_since_last_increase) {
+    if (levels.size() == at) {
+      levels.emplace_back();
+    }
+    dust_search_level_t &level = levels[at];
+    start_dust_level(&level, dust_frames);
+    level.length = length;
+    level.best_so_far = best_so_far;
+    level.steps_since_last_increase = steps_since_last_increase;
+  };
+  // a vector already on the path is skipped
+  auto on_path = [&](const dust_plan_t &dust_frames) {
+    uint64_t fingerprint = dust_frames.fingerprint();
+    for (size_t at = 0; at <= depth; at++) {
+      if (levels[at].fingerprint == fingerprint &&
+          levels[at].dust_frames == dust_frames) {
+        return true;
+      }
+    }
+    return false;
+  };
+  // just for helping compare optimizations
+  auto check_states_left = []() {
+    if (states_checked >= max_states_to_check) {
+      exit(0);
+    }
+  };
+
+  enter_level(0, start_frames, length, length, 0);
+  check_states_left();
+  while (true) {
+    if (levels[depth].batch_pos < levels[depth].batch_count) {
+      if (levels.size() == depth + 1) {
+        levels.emplace_back();
+      }
+      dust_search_level_t &level = levels[depth];
+      const dust_candidate_t &candidate = level.batch[level.batch_pos++];
+      int length = candidate.length;
+      if (length == max_still_frames) {
+        report_still_whole_time(candidate.dust_frames);
+      }
+      found_per_length[length].fetch_add(1, std::memory_order_relaxed);
+      states_checked += 1;
+      if (length > level.best_so_far) {
+        atomic_max(most_frames_lasted, length);
+        enter_level(depth + 1, candidate.dust_frames, length, length, 0);
+        if (length > most_frames_lasted - 5) {
+          printf("new best on path = %d, states_checked = %ld, "
+                 "depth = %zu, most_frames_lasted overall = %d\n",
+                 length, states_checked.load(), depth + 1,
+                 most_frames_lasted.load());
+          print_found_per_length();
+          printf("path we took to get here\n");
+          for (size_t at = 0; at <= depth + 1; at++) {
+            print_waiting_frames(levels[at].dust_frames);
+            printf("   lasted %d\n", levels[at].length);
+          }
+          printf("\n");
+        }
+      } else if (level.steps_since_last_increase < bad_steps_allowed) {
+        enter_level(depth + 1, candidate.dust_frames, length, level.best_so_far,
+                    level.steps_since_last_increase + 1);
+      } else {
+        continue;
+      }
+      depth++;
+      check_states_left();
+      continue;
+    }
+    dust_search_level_t &level = levels[depth];
+    if (level.stage == dust_search_level_t::done) {
+      if (depth == 0) {
+        return;
+      }
+      depth--;
+      continue;
+    }
+    // neighbours are simulated a batch at a time on the lane kernel, then
+    // looked at (and maybe gone into) in the order they were generated
+    stat_timer_scope_t making_neighbours(time_making_neighbours);
+    level.batch_count = 0;
+    while (level.batch_count < dust_batch_size) {
+      if (level.batch.size() == level.batch_count) {
+        level.batch.emplace_back();
+      }
+      dust_candidate_t &candidate = level.batch[level.batch_count];
+      if (!next_dust_neighbour(&level, &candidate)) {
+        break;
+      }
+      if (!on_path(candidate.dust_frames)) {
+        level.batch_count++;
+      }
+    }
+    steps_still_for_state_add_remove_dust_lanes(level.batch.data(),
+                                                level.batch_count);
+    level.batch_pos = 0;
+  }
+}
+
+// the dust vector the searches around one vector start from
+const char *starting_dust_frames =
+    "-----+------------+----------------+---------------------------------++-"
+    "-------+-+------------+--------+----+-+-------------+----+--------+-----"
+    "------------+-+-----------------------------------------";
+
+dust_plan_t read_vector_from_string(std::string frames) {
+  dust_plan_t vec;
+  for (const auto &f : frames) {
+    if (vec.full()) {
+      printf("dust vectors can only be %zu frames long\n", max_dust_frames);
+      exit(1);
+    }
+    if (f == '+') {
+      vec.push_back(true);
+    } else if (f == '-') {
+      vec.push_back(false);
+    } else {
+      printf("shouldn't happen\n");
+    }
+  }
+  return vec;
+}
+
+/* replays a dust vector a frame at a time, printing which objects called rng
+on each frame and where that left rcpscog, to see what pushed it onto a bad
+target */
+void print_rng_trace(const dust_plan_t &dust_frames) {
+  std::vector<rng_attribution_t> calls;
+  object_telemetry_t::trace = &calls;
+  objects_t state = initial_state;
+  for (size_t i = 0; i < dust_frames.size(); i++) {
+    calls.clear();
+    advanceobjects<object_telemetry_t>(&state);
+    printf("frame %zu:", i);
+    for (const auto &call : calls) {
+      printf(" %s %d x%d,", object_kind_names[call.kind], call.index + 1,
+             call.calls);
+    }
+    if (dust_frames[i]) {
+      advanceRNG(&state.rngValue, 4);
+      printf(" dust x4,");
+    }
+    printf(" rcpscog current %d target %d\n",
+           state.rcpscog.currentAngularVelocity,
+           state.rcpscog.targetAngularVelocity);
+  }
+  object_telemetry_t::trace = nullptr;
+  dust_plan_t self = dust_frames;
+  printf("lasted %d\n",
+         steps_still_for_state_add_remove_dust(self, initial_state, 0));
+}
+
+/* a digit for how much of length a perturbation lost, . if it lost nothing and
+^ if it did better */
+char loss_digit(int length, int perturbed) {
+  if (perturbed >= length) {
+    return perturbed == length ? '.' : '^';
+  }
+  int digit = (9 * (length - perturbed) + length - 1) / length;
+  return '0' + std::max(1, std::min(9, digit));
+}
+
+/* How fragile a plan is. Every perturbation of it is evaluated as one batch on
+the lane kernel: each frame flipped, a wait put in before each frame (so the
+rest of the plan is a frame late) and each frame taken out (a frame early),
+each dust press done a frame early and a frame late, and the rng at the start
+moved by up to rng_offsets calls either way. Each perturbation starts from the
+last checkpoint before it, and the ones that end up back on the plan's own
+trajectory stop there. The losses are printed under the plan as a heat map,
+with a digit per frame for how much of the still period the perturbation at
+that frame costs. */
+void analyse_plan(const dust_plan_t &plan, int rng_offsets, int num_threads) {
+  auto start_time = std::chrono::steady_clock::now();
+  const size_t n = plan.size();
+  dust_trajectory_t trajectory;
+  trace_dust_trajectory(plan, &trajectory);
+  const int length = trajectory.length;
+  std::unique_ptr<dust_checkpoints_t> checkpoints(new dust_checkpoints_t);
+  objects_t state = initial_state;
+  for (size_t i = 0;; i++) {
+    checkpoints->record(i, state);
+    if (i == n) {
+      break;
+    }
+    advanceobjects(&state);
+    if (plan[i]) {
+      advanceRNG(&state.rngValue, 4);
+    }
+  }
+
+  enum { flip, wait, remove, early, late, rng, num_perturbations };
+  const char *labels[num_perturbations] = {"flip",  "wait", "remove",
+                                           "early", "late", "rng"};
+  std::vector<dust_candidate_t> candidates;
+  std::vector<std::pair<int, size_t>> perturbations; // kind and frame
+  // the changed plan is the same as plan from frame rejoin_from on
+  auto add = [&](int kind, size_t frame, const dust_plan_t &changed,
+                 size_t from, size_t rejoin_from) {
+    size_t start = dust_checkpoints_t::before(from);
+    candidates.push_back({changed, checkpoints->at(start), start, 0,
+                          rejoin_from < n ? &trajectory : nullptr,
+                          rejoin_from});
+    perturbations.push_back({kind, frame});
+  };
+  for (size_t i = 0; i < n; i++) {
+    dust_plan_t changed = plan;
+    changed.flip(i);
+    add(flip, i, changed, i, i + 1);
+    if (!plan.full()) {
+      changed = dust_plan_t{};
+      for (size_t j = 0; j < n; j++) {
+        if (j == i) {
+          changed.push_back(false);
+        }
+        changed.push_back(plan[j]);
+      }
+      add(wait, i, changed, i, n);
+    }
+    changed = dust_plan_t{};
+    for (size_t j = 0; j < n; j++) {
+      if (j != i) {
+        changed.push_back(plan[j]);
+      }
+    }
+    add(remove, i, changed, i, n);
+    if (!plan[i]) {
+      continue;
+    }
+    if (i > 0 && !plan[i - 1]) {
+      changed = plan;
+      changed.flip(i - 1);
+      changed.flip(i);
+      add(early, i, changed, i - 1, i + 1);
+    }
+    if (i + 1 < n && !plan[i + 1]) {
+      changed = plan;
+      changed.flip(i);
+      changed.flip(i + 1);
+      add(late, i, changed, i, i + 2);
+    }
+  }
+  int rng_index = rng_value_to_index[initial_state.rngValue];
+  for (int offset = -rng_offsets; offset <= rng_offsets && rng_index >= 0;
+       offset++) {
+    if (offset == 0) {
+      continue;
+    }
+    objects_t snapshot = initial_state;
+    snapshot.rngValue =
+        rng_index_to_value[(rng_index + offset + rng_cycle_length) %
+                           rng_cycle_length];
+    candidates.push_back({plan, snapshot, 0, 0, nullptr, 0});
+    perturbations.push_back({rng, (size_t)(offset + rng_offsets)});
+  }
+  steps_still_for_state_add_remove_dust_threaded(
+      candidates.data(), candidates.size(), num_threads);
+  double milliseconds = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start_time)
+                            .count();
+
+  std::vector<std::string> rows(num_perturbations - 1, std::string(n, ' '));
+  std::vector<int> early_length(n, -1);
+  std::vector<int> late_length(n, -1);
+  std::vector<int> rng_length(2 * rng_offsets + 1, length);
+  int perturbations_losing = 0;
+  for (size_t c = 0; c < candidates.size(); c++) {
+    int kind = perturbations[c].first;
+    size_t frame = perturbations[c].second;
+    int perturbed = candidates[c].length;
+    perturbations_losing += perturbed < length;
+    if (kind == rng) {
+      rng_length[frame] = perturbed;
+      continue;
+    }
+    rows[kind][frame] = loss_digit(length, perturbed);
+    if (kind == early) {
+      early_length[frame] = perturbed;
+    } else if (kind == late) {
+      late_length[frame] = perturbed;
+    }
+  }
+
+  printf("the plan lasts %d, %zu perturbations of it checked in %.1f ms, %d "
+         "of them do worse\n",
+         length, candidates.size(), milliseconds, perturbations_losing);
+  printf("%-7s", "plan");
+  for (size_t i = 0; i < n; i++) {
+    printf("%c", plan[i] ? '+' : '-');
+  }
+  printf("\n");
+  for (int kind = 0; kind < rng; kind++) {
+    printf("%-7s%s\n", labels[kind], rows[kind].c_str());
+  }
+  printf("\n");
+  for (size_t i = 0; i < n; i++) {
+    if (!plan[i]) {
+      continue;
+    }
+    int worst = length;
+    printf("press at frame %zu: a frame early", i);
+    if (early_length[i] >= 0) {
+      printf(" lasts %d", early_length[i]);
+      worst = std::min(worst, early_length[i]);
+    } else {
+      printf(" is another press");
+    }
+    printf(", a frame late");
+    if (late_length[i] >= 0) {
+      printf(" lasts %d", late_length[i]);
+      worst = std::min(worst, late_length[i]);
+    } else {
+      printf(" is another press");
+    }
+    printf("%s\n", worst < length ? ", critical" : "");
+  }
+  if (rng_offsets > 0) {
+    if (rng_index < 0) {
+      printf("the starting rng is off the cycle, so it has no offsets\n");
+      return;
+    }
+    printf("rng offsets %d to %d last", -rng_offsets, rng_offsets);
+    for (int length_at_offset : rng_length) {
+      printf(" %d", length_at_offset);
+    }
+    printf("\n");
+  }
+}
+
+/* the files in a directory, in name order */
+std::vector<std::string> stroop_file_names(const char *directory) {
+  DIR *dir = opendir(directory);
+  if (dir == nullptr) {
+    printf("%s: %s\n", directory, strerror(errno));
+    exit(1);
+  }
+  std::vector<std::string> names;
+  while (dirent *entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+/* loads every STROOP file in a directory, in name order, and prints how long
+the cog stays still from each one over every seed */
+void sweep_stroop_directory(const char *directory, int num_threads) {
+  std::vector<std::string> names = stroop_file_names(directory);
+  int loaded = 0;
+  auto start_time = std::chrono::steady_clock::now();
+  for (const auto &name : names) {
+    std::string path = std::string(directory) + "/" + name;
+    objects_t state;
+    if (!load_stroop_state(path.c_str(), &state)) {
+      continue;
+    }
+    loaded++;
+    auto best = steps_still_for_state(&state, -1, num_threads);
+    printf("%s: still for %d frames from seed %d\n", name.c_str(),
+           best.first, best.second);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  printf("swept %d of %zu files in %.2f seconds\n", loaded, names.size(),
+         seconds);
+}
+
+/* A pool of worker threads that each own a deque of tasks. A worker pushes and
+pops its own tasks at the back, so it keeps diving depth first just like the
+single threaded search, and a worker with nothing to do steals the oldest task
+from the front of somebody else's deque. Tasks may submit more tasks. */
+class work_stealing_pool {
+public:
+  explicit work_stealing_pool(int num_threads) : queues(num_threads) {
+    for (int i = 0; i < num_threads; i++) {
+      workers.emplace_back([this, i] { worker_loop(i); });
+    }
+  }
+
+  ~work_stealing_pool() {
+    shutting_down = true;
+    wake_workers.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  int num_threads() const { return (int)queues.size(); }
+
+  // the index of the calling worker thread, -1 if not called from this pool
+  int current_worker() const {
+    return current_pool == this ? current_worker_index : -1;
+  }
+
+  void submit(std::function<void()> task) {
+    int worker = current_worker();
+    int queue_idx = worker >= 0 ? worker
+                                : (int)(next_queue++ % queues.size());
+    pending_tasks++;
+    {
+      std::lock_guard<std::mutex> lock(queues[queue_idx].mutex);
+      queues[queue_idx].tasks.push_back(std::move(task));
+    }
+    if (sleeping_workers.load() > 0) {
+      wake_workers.notify_one();
+    }
+  }
+
+  // blocks until every submitted task (and everything they submitted) is done
+  void wait_until_idle() {
+    std::unique_lock<std::mutex> lock(idle_mutex);
+    became_idle.wait(lock, [this] { return pending_tasks.load() == 0; });
+  }
+
+private:
+  struct task_queue_t {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool pop_own(int worker, std::function<void()> &task) {
+    std::lock_guard<std::mutex> lock(queues[worker].mutex);
+    if (queues[worker].tasks.empty()) {
+      return false;
+    }
+    task = std::move(queues[worker].tasks.back());
+    queues[worker].tasks.pop_back();
+    return true;
+  }
+
+  bool steal(int worker, std::function<void()> &task) {
+    for (size_t i = 1; i < queues.size(); i++) {
+      auto &victim = queues[(worker + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void worker_loop(int worker) {
+    current_pool = this;
+    current_worker_index = worker;
+    std::function<void()> task;
+    while (!shutting_down) {
+      if (pop_own(worker, task) || steal(worker, task)) {
+        {
+          stat_timer_scope_t timer(time_bookkeeping);
+          task();
+        }
+        task = nullptr;
+        if (--pending_tasks == 0) {
+          std::lock_guard<std::mutex> lock(idle_mutex);
+          became_idle.notify_all();
+        }
+        continue;
+      }
+      // nothing to run or steal, nap until someone submits more work
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      sleeping_workers++;
+      wake_workers.wait_for(lock, std::chrono::milliseconds(1));
+      sleeping_workers--;
+    }
+  }
+
+  static thread_local const work_stealing_pool *current_pool;
+  static thread_local int current_worker_index;
+
+  std::vector<task_queue_t> queues;
+  std::vector<std::thread> workers;
+  std::atomic<long> pending_tasks{0};
+  std::atomic<unsigned> next_queue{0};
+  std::atomic<int> sleeping_workers{0};
+  std::atomic<bool> shutting_down{false};
+  std::mutex sleep_mutex;
+  std::condition_variable wake_workers;
+  std::mutex idle_mutex;
+  std::condition_variable became_idle;
+};
+
+thread_local const work_stealing_pool *work_stealing_pool::current_pool =
+    nullptr;
+thread_local int work_stealing_pool::current_worker_index = -1;
+
+/* A lossy, lock-free set of 64 bit fingerprints with a fixed memory budget.
+Each fingerprint gets a short linear probe window, and if that window is full
+the fingerprint just isn't recorded, so in the worst case we re-simulate
+something instead of running out of memory on a long run. */
+class fingerprint_set {
+public:
+  explicit fingerprint_set(int log2_capacity)
+      : mask((size_t(1) << log2_capacity) - 1),
+        slots(new std::atomic<uint64_t>[mask + 1]()) {}
+
+  // returns false if the fingerprint was already in the set
+  bool insert(uint64_t fingerprint) {
+    if (fingerprint == 0) { // 0 marks an empty slot
+      fingerprint = 1;
+    }
+    size_t home = (fingerprint * 0x9E3779B97F4A7C15ULL) >> 20;
+    for (size_t probe = 0; probe < 16; probe++) {
+      auto &slot = slots[(home + probe) & mask];
+      uint64_t current = slot.load(std::memory_order_relaxed);
+      if (current == 0 &&
+          slot.compare_exchange_strong(current, fingerprint,
+                                       std::memory_order_relaxed)) {
+        return true;
+      }
+      if (current == fingerprint) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool contains(uint64_t fingerprint) const {
+    if (fingerprint == 0) {
+      fingerprint = 1;
+    }
+    size_t home = (fingerprint * 0x9E3779B97F4A7C15ULL) >> 20;
+    for (size_t probe = 0; probe < 16; probe++) {
+      uint64_t current =
+          slots[(home + probe) & mask].load(std::memory_order_relaxed);
+      if (current == fingerprint) {
+        return true;
+      }
+      if (current == 0) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+private:
+  size_t mask;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots;
+};
+
+/* Multithreaded version of the add/remove dust search. Every neighbour that
+check_small_changes_add_remove_dust would try becomes its own task on the work
+stealing pool. All threads share most_frames_lasted, states_checked and one
+visited set, so a dust vector is only simulated once no matter which thread
+gets to it first. The path to a vector is a linked list of immutable nodes so
+tasks can share it without copying. */
+typedef struct dust_path_t {
+  dust_plan_t dust_frames;
+  size_t length;
+  std::shared_ptr<const dust_path_t> parent;
+} dust_path_t;
+
+typedef struct threaded_dust_search_t {
+  explicit threaded_dust_search_t(int num_threads, int bad_steps_allowed)
+      : pool(num_threads), visited(24), bad_steps_allowed(bad_steps_allowed) {}
+  work_stealing_pool pool;
+  fingerprint_set visited;
+  int bad_steps_allowed;
+  std::atomic<bool> out_of_states{false};
+  std::mutex print_mutex;
+} threaded_dust_search_t;
+
+void print_dust_path(const dust_path_t *path) {
+  std::vector<const dust_path_t *> nodes;
+  for (; path != nullptr; path = path->parent.get()) {
+    nodes.push_back(path);
+  }
+  for (auto it = nodes.rbegin(); it != nodes.rend(); it++) {
+    print_waiting_frames((*it)->dust_frames);
+    printf("   lasted %zu\n", (*it)->length);
+  }
+}
+
+void threaded_check_small_changes_add_remove_dust(
+    threaded_dust_search_t &search, int best_so_far,
+    int steps_since_last_increase, int depth,
+    std::shared_ptr<const dust_path_t> path);
+
+void threaded_check_length_and_recurse_add_remove_dust(
+    threaded_dust_search_t &search, int best_so_far,
+    int steps_since_last_increase, int depth,
+    const dust_plan_t &dust_frames, int length,
+    const std::shared_ptr<const dust_path_t> &path) {
+  if (length == max_still_frames) {
+    std::lock_guard<std::mutex> lock(search.print_mutex);
+    report_still_whole_time(dust_frames);
+  }
+  found_per_length[length].fetch_add(1, std::memory_order_relaxed);
+  long checked = ++states_checked;
+  if (checked >= max_states_to_check) {
+    search.out_of_states = true;
+  }
+  if (length > best_so_far) {
+    int best_overall = atomic_max(most_frames_lasted, length);
+    auto node = std::make_shared<const dust_path_t>(
+        dust_path_t{dust_frames, (size_t)length, path});
+    if (length > best_overall - 5) {
+      std::lock_guard<std::mutex> lock(search.print_mutex);
+      printf("new best on path = %d, states_checked = %ld, "
+             "depth = %d, most_frames_lasted overall = %d\n",
+             length, checked, depth, most_frames_lasted.load());
+      print_found_per_length();
+      printf("path we took to get here\n");
+      print_dust_path(node.get());
+      printf("\n");
+    }
+    threaded_check_small_changes_add_remove_dust(search, length, 0, depth + 1,
+                                                 node);
+  } else if (steps_since_last_increase < search.bad_steps_allowed) {
+    auto node = std::make_shared<const dust_path_t>(
+        dust_path_t{dust_frames, (size_t)length, path});
+    threaded_check_small_changes_add_remove_dust(
+        search, best_so_far, steps_since_last_increase + 1, depth + 1, node);
+  }
+}
+
+// same neighbours as check_small_changes_add_remove_dust, but every batch of
+// them is handed to the pool instead of being evaluated (and recursed into) in
+// place
+void threaded_check_small_changes_add_remove_dust(
+    threaded_dust_search_t &search, int best_so_far,
+    int steps_since_last_increase, int depth,
+    std::shared_ptr<const dust_path_t> path) {
+  stat_timer_scope_t timer(time_making_neighbours);
+  // the batches point into this, so each one keeps it alive
+  auto trajectory = std::make_shared<dust_trajectory_t>();
+  trace_dust_trajectory(path->dust_frames, trajectory.get());
+  std::vector<dust_candidate_t> batch;
+  auto submit_batch = [&]() {
+    if (batch.empty()) {
+      return;
+    }
+    search.pool.submit([&search, best_so_far, steps_since_last_increase, depth,
+                        path, trajectory,
+                        candidates = std::move(batch)]() mutable {
+      if (search.out_of_states) {
+        return;
+      }
+      steps_still_for_state_add_remove_dust_lanes(candidates.data(),
+                                                  candidates.size());
+      for (const auto &candidate : candidates) {
+        threaded_check_length_and_recurse_add_remove_dust(
+            search, best_so_far, steps_since_last_increase, depth,
+            candidate.dust_frames, candidate.length, path);
+      }
+    });
+    batch.clear();
+  };
+  auto try_neighbour = [&](const dust_plan_t &dust_frames,
+                           const objects_t &state, size_t start,
+                           size_t rejoin_from = max_dust_frames) {
+    if (!search.visited.insert(dust_frames.fingerprint())) {
+      return;
+    }
+    batch.push_back(
+        {dust_frames, state, start, 0, trajectory.get(), rejoin_from});
+    if (batch.size() == dust_batch_size) {
+      submit_batch();
+    }
+  };
+  objects_t state = initial_state;
+  dust_checkpoints_t checkpoints;
+  dust_plan_t dust_frames = path->dust_frames;
+  for (size_t i = 0; i < dust_frames.size(); i++) {
+    if (search.out_of_states) {
+      return;
+    }
+    checkpoints.record(i, state);
+    // first try just swapping this frame
+    dust_frames.flip(i);
+    try_neighbour(dust_frames, state, i, i + 1);
+
+    size_t biggest_move_size = 5;
+
+    // then try moving a later frame to this frame
+    for (size_t j = i + 1;
+         j < std::min(dust_frames.size(), i + biggest_move_size); j++) {
+      if (dust_frames[j] == dust_frames[i] && dust_frames[i]) {
+        dust_frames.flip(j);
+        try_neighbour(dust_frames, state, i, j + 1);
+        dust_frames.flip(j);
+      }
+    }
+    dust_frames.flip(i);
+    advanceobjects(&state);
+    if (dust_frames[i]) {
+      advanceRNG(&state.rngValue, 4);
+    }
+  }
+  // try adding a frame either way
+  if (!dust_frames.full()) {
+    dust_frames.push_back(true);
+    try_neighbour(dust_frames, state, dust_frames.size());
+    dust_frames.set(dust_frames.size() - 1, false);
+    try_neighbour(dust_frames, state, dust_frames.size());
+    dust_frames.pop_back();
+  }
+  // try removing a frame
+  if (!dust_frames.empty()) {
+    dust_frames.pop_back();
+    size_t start = dust_checkpoints_t::before(dust_frames.size());
+    try_neighbour(dust_frames, checkpoints.at(start), start);
+  }
+  submit_batch();
+}
+
+void runsimulation_add_remove_dust_threaded(int frames_to_wait,
+                                            int bad_steps_allowed,
+                                            int num_threads) {
+  printf("Running on %d threads\n", num_threads);
+  threaded_dust_search_t search(num_threads, bad_steps_allowed);
+  dust_plan_t dust_frames;
+  for (int i = 0; i < frames_to_wait && !dust_frames.full(); i++) {
+    dust_frames.push_back(false);
+  }
+  dust_frames = read_vector_from_string(starting_dust_frames);
+  auto start_time = std::chrono::steady_clock::now();
+  while (!search.out_of_states) {
+    objects_t state = initial_state;
+    search.visited.insert(dust_frames.fingerprint());
+    int length = steps_still_for_state_add_remove_dust(dust_frames, state, 0);
+    states_checked += 1;
+    printf("start is %d\n", length);
+    search.pool.submit([&search, length, dust_frames] {
+      threaded_check_small_changes_add_remove_dust(
+          search, length, 0, 1,
+          std::make_shared<const dust_path_t>(
+              dust_path_t{dust_frames, (size_t)length, nullptr}));
+    });
+    search.pool.wait_until_idle();
+    if (!search.out_of_states) {
+      printf("finished seraching from the starting point, starting over\n");
+      dust_frames = {};
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  printf("checked %ld states in %.2f seconds (%.0f states/sec), "
+         "most_frames_lasted overall = %d\n",
+         states_checked.load(), seconds, states_checked.load() / seconds,
+         most_frames_lasted.load());
+}
+
+// start with state, and a number of frames to stay wait
+// make a new state by changing a state from nothing to dust, dust to nothing,
+// or adding or removing a frame to wait
+void runsimulation_add_remove_dust(int frames_to_wait, int bad_steps_allowed) {
+  printf("Running\n");
+  // initialize_rand();
+
+  dust_plan_t dust_frames;
+  for (int i = 0; i < frames_to_wait && !dust_frames.full(); i++) {
+    dust_frames.push_back(false);
   }
-  for (a = 0; a < 2; a++) {
-    // inputstate->rotatingtriangularprisms[a].max = randbetween<0, 6>() * 20
-    // + 5; inputstate->rotatingtriangularprisms[a].timer =
-    //     randbetween(0, inputstate->rotatingtriangularprisms[a].max + 45);
-    all_small_changes_to_field(
-        &inputstate->rotatingtriangularprisms[a].timer, 0,
-        (inputstate->rotatingtriangularprisms[a].max + 45) / 5, 5, 0,
-        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  // for (size_t i = 0; i < dust_frames.size(); i++) {
+  //   dust_frames[i] = randbetween<0, 10>() == 0;
+  // }
+  dust_frames = read_vector_from_string(starting_dust_frames);
+  while (true) {
+    objects_t state = initial_state;
+    int length = steps_still_for_state_add_remove_dust(dust_frames, state, 0);
+    states_checked += 1;
+    printf("start is %d\n", length);
+    search_add_remove_dust(dust_frames, length, bad_steps_allowed);
+    printf("finished seraching from the starting point, starting over\n");
+    dust_frames = {};
+    for (size_t i = 0; i < dust_frames.size(); i++) {
+      dust_frames.set(i, randbetween<0, 10>() == 0);
+    }
   }
-  for (a = 0; a < 4; a++) {
-    all_small_changes_to_field(&inputstate->pendulums[a].waitingTimer, 0, 34, 1,
-                               0, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->pendulums[a].accelerationDirection,
-                               0, 1, 2, -1, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->pendulums[a].angle, 0, 1000, 13,
-                               -6500, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->pendulums[a].angularVelocity, 1, 5,
-                               21, -63, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->pendulums[a].accelerationMagnitude,
-                               0, 1, 29, 13, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
+}
+
+/* One chain of the parallel tempering search: a dust vector, how long it
+lasted, and the temperature it is sampled at. A neighbour that lasts longer is
+always taken, and one that lasts d frames less is taken with probability
+exp(-d / temperature), so hot replicas wander off local optima while cold
+ones climb. The checkpoints of the current vector let every neighbour start
+near the frame it changes. */
+typedef struct anneal_replica_t {
+  dust_plan_t dust_frames;
+  int length;
+  double temperature;
+  std::mt19937 rng;
+  dust_checkpoints_t checkpoints;
+  std::vector<dust_candidate_t> batch;
+  long accepted;
+} anneal_replica_t;
+
+// the coldest and hottest temperatures, in frames of still time
+const double anneal_min_temperature = 0.5;
+const double anneal_max_temperature = 12.0;
+// batches of neighbours each replica goes through between exchanges
+const int anneal_batches_per_round = 8;
+
+void anneal_take(anneal_replica_t *replica, const dust_plan_t &dust_frames,
+                 int length) {
+  replica->dust_frames = dust_frames;
+  replica->length = length;
+  objects_t state = initial_state;
+  for (size_t i = 0;; i++) {
+    replica->checkpoints.record(i, state);
+    if (i == dust_frames.size()) {
+      break;
+    }
+    advanceobjects(&state);
+    if (dust_frames[i]) {
+      advanceRNG(&state.rngValue, 4);
+    }
   }
-  all_small_changes_to_field(&inputstate->treadmill.currentSpeed, -5, 5, 10, 0,
-                             best_so_far, inputstate, steps_since_last_increase,
-                             depth, seed_idx);
-  all_small_changes_to_field(&inputstate->treadmill.targetSpeed, 0, 1, 100, -50,
-                             best_so_far, inputstate, steps_since_last_increase,
-                             depth, seed_idx);
-  // inputstate->treadmill.max = randbetween<0, 6>() * 20 + 10;
-  all_small_changes_to_field(
-      &inputstate->treadmill.counter, 0, inputstate->treadmill.max / 5, 5, 0,
-      best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+}
 
-  for (a = 0; a < 12; a++) {
-    inputstate->pushers[a].max_index = randbetween<0, 3>();
-    all_small_changes_to_field(&inputstate->pushers[a].countdown, 0, 119, 1, 0,
-                               best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->pushers[a].state, 0, 3, 1, 0,
-                               best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(
-        &inputstate->pushers[a].counter, 0,
-        max_index_to_max[inputstate->pushers[a].max_index], 1, 0, best_so_far,
-        inputstate, steps_since_last_increase, depth, seed_idx);
+/* writes a random neighbour of the replica's vector to candidate: flipping a
+frame, moving a frame a few frames either way, or adding or removing one at
+the end */
+void anneal_propose(anneal_replica_t *replica, dust_candidate_t *candidate) {
+  stat_timer_scope_t timer(time_making_neighbours);
+  const dust_plan_t &dust_frames = replica->dust_frames;
+  const size_t n = dust_frames.size();
+  candidate->dust_frames = dust_frames;
+  size_t changed_from;
+  int kind = std::uniform_int_distribution<int>(0, 9)(replica->rng);
+  size_t i = n == 0 ? 0 : replica->rng() % n;
+  size_t j = i + std::uniform_int_distribution<int>(-4, 4)(replica->rng);
+  if (n == 0 || (kind == 0 && !dust_frames.full())) {
+    candidate->dust_frames.push_back(replica->rng() & 1);
+    changed_from = n;
+  } else if (kind == 1) {
+    candidate->dust_frames.pop_back();
+    changed_from = n - 1;
+  } else if (kind <= 3 && j < n && dust_frames[i] != dust_frames[j]) {
+    candidate->dust_frames.flip(i);
+    candidate->dust_frames.flip(j);
+    changed_from = std::min(i, j);
+  } else {
+    candidate->dust_frames.flip(i);
+    changed_from = i;
   }
+  candidate->dust_frame_to_start_with =
+      dust_checkpoints_t::before(changed_from);
+  candidate->state =
+      replica->checkpoints.at(candidate->dust_frame_to_start_with);
+  candidate->parent = nullptr;
+}
 
-  for (a = 0; a < 4; a++) {
-    all_small_changes_to_field(&inputstate->cogs[a].currentAngularVelocity, -24,
-                               24, 50, 0, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->cogs[a].targetAngularVelocity, -6,
-                               6, 20, 0, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
+/* evaluates anneal_batches_per_round batches of neighbours of the replica,
+moving to the first neighbour of a batch that it accepts, the rest of that
+batch are neighbours of a vector it has left */
+void anneal_round(anneal_replica_t *replica, std::mutex *print_mutex) {
+  stat_timer_scope_t timer(time_bookkeeping);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  replica->batch.resize(dust_batch_size);
+  for (int b = 0; b < anneal_batches_per_round; b++) {
+    for (auto &candidate : replica->batch) {
+      anneal_propose(replica, &candidate);
+    }
+    steps_still_for_state_add_remove_dust_lanes(replica->batch.data(),
+                                                replica->batch.size());
+    states_checked += replica->batch.size();
+    for (const auto &candidate : replica->batch) {
+      int length = candidate.length;
+      found_per_length[length].fetch_add(1, std::memory_order_relaxed);
+      if (length == max_still_frames) {
+        // ends the process from this replica's thread while the others keep
+        // simulating, holding print_mutex so none of them prints under it
+        std::lock_guard<std::mutex> lock(*print_mutex);
+        report_still_whole_time(candidate.dust_frames);
+      }
+      if (length > most_frames_lasted.load(std::memory_order_relaxed) &&
+          atomic_max(most_frames_lasted, length) == length) {
+        std::lock_guard<std::mutex> lock(*print_mutex);
+        printf("new best = %d, states_checked = %ld, temperature = %.2f\n",
+               length, states_checked.load(), replica->temperature);
+        print_found_per_length();
+        print_waiting_frames(candidate.dust_frames);
+        printf("   lasted %d\n\n", length);
+      }
+      int delta = length - replica->length;
+      if (delta >= 0 ||
+          uniform(replica->rng) < exp(delta / replica->temperature)) {
+        anneal_take(replica, candidate.dust_frames, length);
+        replica->accepted++;
+        break;
+      }
+    }
   }
-  for (a = 0; a < 2; a++) {
-    all_small_changes_to_field(
-        &inputstate->spinningtriangles[a].currentAngularVelocity, -24, 24, 50,
-        0, best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(
-        &inputstate->spinningtriangles[a].targetAngularVelocity, -6, 6, 20, 0,
-        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+}
+
+/* Parallel tempering over dust vectors. Each replica runs at its own
+temperature, spaced geometrically between the coldest and hottest, and each
+round they all take a few batches of steps in parallel, one thread each. Then
+neighbouring temperatures offer to swap vectors, which lets a vector that got
+somewhere good while hot settle down in a cold replica. Replicas only meet at
+the swaps, so the run only depends on the seeds they start with. */
+void runsimulation_anneal(int frames_to_wait, int num_replicas) {
+  printf("Running parallel tempering with %d replicas\n", num_replicas);
+  std::vector<anneal_replica_t> replicas(num_replicas);
+  std::mt19937 exchange_rng(gen());
+  dust_plan_t dust_frames;
+  for (int i = 0; i < frames_to_wait && !dust_frames.full(); i++) {
+    dust_frames.push_back(false);
   }
-  all_small_changes_to_field(&inputstate->pitblock.height, 0, 30, 11, -71,
-                             best_so_far, inputstate, steps_since_last_increase,
-                             depth, seed_idx);
-  all_small_changes_to_field(&inputstate->pitblock.verticalSpeed, 0, 1, 20, -9,
-                             best_so_far, inputstate, steps_since_last_increase,
-                             depth, seed_idx);
-  all_small_changes_to_field(&inputstate->pitblock.state, 0, 1, 1, 0,
-                             best_so_far, inputstate, steps_since_last_increase,
-                             depth, seed_idx);
-  // inputstate->pitblock.max = (randbetween<0, 6>() * 20 + 9) % 110 + 1;
-  all_small_changes_to_field(
-      &inputstate->pitblock.counter, 0, inputstate->pitblock.max, 1, 0,
-      best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
-  for (a = 0; a < 2; a++) {
-    all_small_changes_to_field(&inputstate->hands[a].angle, -6, 6, 182, 0,
-                               best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->hands[a].targetAngle, -1, 1, 1092,
-                               0, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->hands[a].displacement, 0, 1, 2184,
-                               -1092, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    // inputstate->hands[a].directionTimer =
-    //     (randbetween<0, 5>() * 60 + 29) % 270 + 1;
-    // inputstate->hands[a].max = randbetween<0, 2>() * 20 + 10;
-    all_small_changes_to_field(
-        &inputstate->hands[a].timer, 0, inputstate->hands[a].max, 1, 0,
-        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  objects_t state = initial_state;
+  int length = steps_still_for_state_add_remove_dust(dust_frames, state, 0);
+  printf("start is %d\n", length);
+  for (int r = 0; r < num_replicas; r++) {
+    anneal_replica_t &replica = replicas[r];
+    replica.temperature =
+        num_replicas == 1
+            ? anneal_min_temperature
+            : anneal_min_temperature *
+                  pow(anneal_max_temperature / anneal_min_temperature,
+                      (double)r / (num_replicas - 1));
+    replica.rng.seed(gen());
+    replica.accepted = 0;
+    anneal_take(&replica, dust_frames, length);
   }
-  for (a = 0; a < 14; a++) {
-    // all_small_changes_to_field(&inputstate->spinners[a].direction, 0, 1, 2,
-    // -1,
-    //                            best_so_far, inputstate,
-    //                            steps_since_last_increase, depth, seed_idx);
-    // inputstate->spinners[a].max = randbetween<0, 3>() * 30 + 30;
-    all_small_changes_to_field(
-        &inputstate->spinners[a].counter, 0, inputstate->spinners[a].max, 1, 0,
-        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  std::mutex print_mutex;
+  long swaps = 0;
+  auto start_time = std::chrono::steady_clock::now();
+  for (long round = 0; states_checked < max_states_to_check; round++) {
+    std::vector<std::thread> threads;
+    for (auto &replica : replicas) {
+      threads.emplace_back(anneal_round, &replica, &print_mutex);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    // alternate between swapping pairs starting at even and odd replicas
+    for (int r = round % 2; r + 1 < num_replicas; r += 2) {
+      anneal_replica_t &cold = replicas[r];
+      anneal_replica_t &hot = replicas[r + 1];
+      double exponent = (hot.length - cold.length) *
+                        (1 / cold.temperature - 1 / hot.temperature);
+      if (exponent >= 0 ||
+          std::uniform_real_distribution<double>(0.0, 1.0)(exchange_rng) <
+              exp(exponent)) {
+        std::swap(cold.dust_frames, hot.dust_frames);
+        std::swap(cold.length, hot.length);
+        std::swap(cold.checkpoints, hot.checkpoints);
+        swaps++;
+      }
+    }
+    if (round % 100 == 99) {
+      printf("round %ld, %ld swaps, replicas at", round + 1, swaps);
+      for (const auto &replica : replicas) {
+        printf(" %d", replica.length);
+      }
+      printf("\n");
+    }
   }
-  for (a = 0; a < 6; a++) {
-    // inputstate->wheels[a].max = randbetween<0, 2>() * 20 + 10;
-    all_small_changes_to_field(&inputstate->wheels[a].angle, -14, 14, 234, 0,
-                               best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->wheels[a].targetAngle, -1, 1, 3276,
-                               0, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    all_small_changes_to_field(&inputstate->wheels[a].displacement, 0, 1,
-                               2 * 3276, -3276, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
-    // inputstate->wheels[a].directionTimer =
-    //     (randbetween<0, 5>() * 60 + 29) % 270 + 1;
-    all_small_changes_to_field(
-        &inputstate->wheels[a].timer, 0, inputstate->wheels[a].max, 1, 0,
-        best_so_far, inputstate, steps_since_last_increase, depth, seed_idx);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  printf("checked %ld states in %.2f seconds (%.0f states/sec), "
+         "most_frames_lasted overall = %d\n",
+         states_checked.load(), seconds, states_checked.load() / seconds,
+         most_frames_lasted.load());
+}
+
+// vectors in each generation of the genetic search, and how many of the best
+// are carried over unchanged
+const size_t genetic_population = 4 * dust_batch_size;
+const size_t genetic_elites = 8;
+
+/* writes a child of a and b to child: the frames of a up to a random cut and
+the frames of b after it, then a few flips, a shifted dust frame, and now and
+then a frame added or removed at the end */
+void genetic_breed(const dust_plan_t &a, const dust_plan_t &b,
+                   std::mt19937 &rng, dust_plan_t *child) {
+  stat_timer_scope_t timer(time_making_neighbours);
+  size_t n = std::max(a.size(), b.size());
+  size_t cut = n == 0 ? 0 : rng() % n;
+  *child = dust_plan_t{};
+  for (size_t i = 0; i < b.size(); i++) {
+    child->push_back(i < cut ? i < a.size() && a[i] : b[i]);
   }
-  for (a = 0; a < 2; a++) {
-    // inputstate->elevators[a].max = randbetween<1, 6>() * 30;
-    all_small_changes_to_field(&inputstate->elevators[a].counter, 0, 180, 1, 0,
-                               best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
+  if (child->empty()) {
+    child->push_back(false);
   }
-  all_small_changes_to_field(&inputstate->sixthcog.currentAngularVelocity, -24,
-                             24, 50, 0, best_so_far, inputstate,
-                             steps_since_last_increase, depth, seed_idx);
-  all_small_changes_to_field(&inputstate->sixthcog.targetAngularVelocity, -6, 6,
-                             20, 0, best_so_far, inputstate,
-                             steps_since_last_increase, depth, seed_idx);
+  size_t size = child->size();
+  int flips = std::uniform_int_distribution<int>(0, 2)(rng);
+  for (int f = 0; f < flips; f++) {
+    child->flip(rng() % size);
+  }
+  size_t i = rng() % size;
+  size_t j = i + std::uniform_int_distribution<int>(-4, 4)(rng);
+  if (j < size && (*child)[i] != (*child)[j]) {
+    child->flip(i);
+    child->flip(j);
+  }
+  int ends = std::uniform_int_distribution<int>(0, 9)(rng);
+  if (ends == 0 && !child->full()) {
+    child->push_back(rng() & 1);
+  } else if (ends == 1 && size > 1) {
+    child->pop_back();
+  }
+}
 
-  all_small_changes_to_field(&inputstate->thwomp.height, 6192, 6607, 1, 0,
-                             best_so_far, inputstate, steps_since_last_increase,
-                             depth, seed_idx);
-  // inputstate->thwomp.max = randbetween<10, 39>();
-  all_small_changes_to_field(
-      &inputstate->thwomp.counter, 0, inputstate->thwomp.max, 1, 0, best_so_far,
-      inputstate, steps_since_last_increase, depth, seed_idx);
-  all_small_changes_to_field(&inputstate->thwomp.state, 0, 4, 1, 0, best_so_far,
-                             inputstate, steps_since_last_increase, depth,
-                             seed_idx);
-  all_small_changes_to_field(&inputstate->thwomp.verticalSpeed, 0, 104, -4, 0,
-                             best_so_far, inputstate, steps_since_last_increase,
-                             depth, seed_idx);
-  for (a = 0; a < 2; a++) {
-    all_small_changes_to_field(&inputstate->bobombs[a].blinkingTimer, 0, 15, 1,
-                               0, best_so_far, inputstate,
-                               steps_since_last_increase, depth, seed_idx);
+/* A genetic search over dust vectors. Every generation is bred from the one
+before by tournament selection, crossover and mutation, then evaluated as one
+batch, split into a slice per thread and run through the lane kernel. The best
+few of every generation survive unchanged so nothing good is ever lost. */
+void runsimulation_genetic(int frames_to_wait, int num_threads) {
+  printf("Running genetic search with a population of %zu on %d threads\n",
+         genetic_population, num_threads);
+  stat_timer_scope_t timer(time_bookkeeping);
+  std::mt19937 rng(gen());
+  std::vector<dust_candidate_t> population(genetic_population);
+  std::vector<dust_candidate_t> children(genetic_population);
+  // the first generation is a random sprinkle of dust on the waiting frames
+  for (auto &individual : population) {
+    for (int i = 0; i < frames_to_wait && !individual.dust_frames.full();
+         i++) {
+      individual.dust_frames.push_back(randbetween<0, 10>() == 0);
+    }
+  }
+  auto evaluate = [&](std::vector<dust_candidate_t> &generation) {
+    for (auto &individual : generation) {
+      individual.state = initial_state;
+      individual.dust_frame_to_start_with = 0;
+      individual.parent = nullptr;
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      size_t first = generation.size() * t / num_threads;
+      size_t last = generation.size() * (t + 1) / num_threads;
+      threads.emplace_back([&generation, first, last] {
+        steps_still_for_state_add_remove_dust_lanes(&generation[first],
+                                                    last - first);
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    states_checked += generation.size();
+    for (const auto &individual : generation) {
+      int length = individual.length;
+      found_per_length[length].fetch_add(1, std::memory_order_relaxed);
+      if (length == max_still_frames) {
+        report_still_whole_time(individual.dust_frames);
+      }
+      if (length > most_frames_lasted) {
+        most_frames_lasted = length;
+        printf("new best = %d, states_checked = %ld\n", length,
+               states_checked.load());
+        print_found_per_length();
+        print_waiting_frames(individual.dust_frames);
+        printf("   lasted %d\n\n", length);
+      }
+    }
+    std::sort(generation.begin(), generation.end(),
+              [](const dust_candidate_t &a, const dust_candidate_t &b) {
+                return a.length > b.length;
+              });
+  };
+  auto tournament = [&]() -> const dust_candidate_t & {
+    const dust_candidate_t *winner = &population[rng() % population.size()];
+    for (int k = 1; k < 3; k++) {
+      const dust_candidate_t &other = population[rng() % population.size()];
+      if (other.length > winner->length) {
+        winner = &other;
+      }
+    }
+    return *winner;
+  };
+
+  auto start_time = std::chrono::steady_clock::now();
+  evaluate(population);
+  for (long generation = 1; states_checked < max_states_to_check;
+       generation++) {
+    for (size_t i = 0; i < genetic_elites; i++) {
+      children[i].dust_frames = population[i].dust_frames;
+    }
+    for (size_t i = genetic_elites; i < children.size(); i++) {
+      genetic_breed(tournament().dust_frames, tournament().dust_frames, rng,
+                    &children[i].dust_frames);
+    }
+    evaluate(children);
+    std::swap(population, children);
+    if (generation % 100 == 0) {
+      printf("generation %ld, best %d, median %d\n", generation,
+             population[0].length, population[population.size() / 2].length);
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  printf("checked %ld states in %.2f seconds (%.0f states/sec), "
+         "most_frames_lasted overall = %d\n",
+         states_checked.load(), seconds, states_checked.load() / seconds,
+         most_frames_lasted.load());
+}
+
+/* A min-max heap holding at most capacity items: the smallest is at the root,
+the biggest is one of its children, and every level alternates between being
+smaller and bigger than everything under it. Pushing into a full heap drops
+the smallest item, or the new one if it is no bigger, so the heap keeps the
+best items seen within a fixed amount of memory. less orders the items. */
+template <typename T, typename less_t> class bounded_minmax_heap {
+public:
+  explicit bounded_minmax_heap(size_t capacity) : capacity(capacity) {
+    items.reserve(capacity);
+  }
+
+  size_t size() const { return items.size(); }
+  bool empty() const { return items.empty(); }
+
+  // returns false if item was dropped straight away
+  bool push(const T &item) {
+    if (items.size() == capacity) {
+      if (!less(items[0], item)) {
+        return false;
+      }
+      pop_min();
+    }
+    items.push_back(item);
+    bubble_up(items.size() - 1);
+    return true;
+  }
+
+  T pop_min() { return pop_at(0); }
+
+  T pop_max() {
+    size_t at = 0;
+    if (items.size() == 2) {
+      at = 1;
+    } else if (items.size() > 2) {
+      at = less(items[1], items[2]) ? 2 : 1;
+    }
+    return pop_at(at);
+  }
+
+private:
+  static bool is_min_level(size_t i) {
+    int level = 0;
+    for (i++; i > 1; i /= 2) {
+      level++;
+    }
+    return level % 2 == 0;
+  }
+
+  // whether a belongs nearer the root than b on a level of the given kind
+  bool before(const T &a, const T &b, bool min_level) const {
+    return min_level ? less(a, b) : less(b, a);
+  }
+
+  T pop_at(size_t at) {
+    T item = items[at];
+    items[at] = items.back();
+    items.pop_back();
+    if (at < items.size()) {
+      trickle_down(at);
+    }
+    return item;
+  }
+
+  void bubble_up(size_t i) {
+    if (i == 0) {
+      return;
+    }
+    size_t parent = (i - 1) / 2;
+    bool min_level = is_min_level(i);
+    // on the wrong side of the parent, it belongs with the parent's levels
+    if (before(items[parent], items[i], min_level)) {
+      std::swap(items[i], items[parent]);
+      i = parent;
+      min_level = !min_level;
+    }
+    while (i > 2) {
+      size_t grandparent = ((i - 1) / 2 - 1) / 2;
+      if (!before(items[i], items[grandparent], min_level)) {
+        break;
+      }
+      std::swap(items[i], items[grandparent]);
+      i = grandparent;
+    }
+  }
+
+  void trickle_down(size_t i) {
+    bool min_level = is_min_level(i);
+    while (2 * i + 1 < items.size()) {
+      // the first among the children and grandchildren
+      size_t first = 2 * i + 1;
+      size_t candidates[6] = {2 * i + 1, 2 * i + 2, 4 * i + 3,
+                              4 * i + 4, 4 * i + 5, 4 * i + 6};
+      for (size_t c : candidates) {
+        if (c < items.size() && before(items[c], items[first], min_level)) {
+          first = c;
+        }
+      }
+      if (!before(items[first], items[i], min_level)) {
+        return;
+      }
+      std::swap(items[first], items[i]);
+      if (first <= 2 * i + 2) {
+        return; // a child, its own subtree is fine
+      }
+      size_t parent = (first - 1) / 2;
+      if (before(items[parent], items[first], min_level)) {
+        std::swap(items[first], items[parent]);
+      }
+      i = first;
+    }
+  }
+
+  size_t capacity;
+  std::vector<T> items;
+  less_t less;
+};
+
+/* A vector waiting in the beam search's frontier. Vectors that last as long
+are ordered by how different they are from the best one when they were
+found, so the frontier doesn't fill up with copies of one vector. */
+typedef struct beam_entry_t {
+  dust_plan_t dust_frames;
+  int length;
+  int distance_from_best;
+} beam_entry_t;
+
+typedef struct beam_entry_less_t {
+  bool operator()(const beam_entry_t &a, const beam_entry_t &b) const {
+    if (a.length != b.length) {
+      return a.length < b.length;
+    }
+    return a.distance_from_best < b.distance_from_best;
+  }
+} beam_entry_less_t;
+
+// vectors in the beam search's frontier, about 6 MB
+const size_t beam_capacity = 1 << 16;
+
+int dust_plan_distance(const dust_plan_t &a, const dust_plan_t &b) {
+  int distance = std::abs((int)a.size() - (int)b.size());
+  for (size_t w = 0; w < max_dust_frames / 64; w++) {
+    distance += __builtin_popcountll(a.words[w] ^ b.words[w]);
+  }
+  return distance;
+}
+
+/* Best-first search over dust vectors. Each step takes the width best vectors
+out of the frontier, tries every neighbour of each of them the way
+search_add_remove_dust does, one thread per vector at a time, and puts the
+neighbours back in. The frontier is a bounded_minmax_heap, so its memory is
+fixed and the worst vectors fall out of the bottom when it is full. Unlike
+the depth first search nothing good is thrown away when it goes deeper, so
+the best vector so far keeps getting better from the start. */
+void runsimulation_beam(int width, int num_threads) {
+  printf("Running beam search %d wide on %d threads\n", width, num_threads);
+  stat_timer_scope_t timer(time_bookkeeping);
+  bounded_minmax_heap<beam_entry_t, beam_entry_less_t> frontier(beam_capacity);
+  fingerprint_set visited(24);
+  beam_entry_t best;
+  best.dust_frames = read_vector_from_string(starting_dust_frames);
+  objects_t state = initial_state;
+  best.length =
+      steps_still_for_state_add_remove_dust(best.dust_frames, state, 0);
+  best.distance_from_best = 0;
+  printf("start is %d\n", best.length);
+  visited.insert(best.dust_frames.fingerprint());
+  frontier.push(best);
+  most_frames_lasted = best.length;
+
+  typedef struct expansion_t {
+    beam_entry_t from;
+    std::vector<dust_candidate_t> neighbours;
+    std::unordered_set<uint64_t> seen; // repeats within this expansion
+  } expansion_t;
+  std::vector<expansion_t> expansions;
+  std::vector<std::unique_ptr<dust_search_level_t>> levels;
+  for (int t = 0; t < num_threads; t++) {
+    levels.emplace_back(new dust_search_level_t);
+  }
+  // visited is only read while expanding and only written by the merge, so
+  // which expansion keeps a neighbour two of them share doesn't depend on
+  // thread timing
+  auto expand = [&](dust_search_level_t *level, expansion_t *expansion) {
+    stat_timer_scope_t timer(time_making_neighbours);
+    start_dust_level(level, expansion->from.dust_frames);
+    expansion->neighbours.clear();
+    expansion->seen.clear();
+    level->batch.resize(dust_batch_size);
+    while (level->stage != dust_search_level_t::done) {
+      size_t count = 0;
+      while (count < dust_batch_size &&
+             next_dust_neighbour(level, &level->batch[count])) {
+        uint64_t fingerprint = level->batch[count].dust_frames.fingerprint();
+        if (!visited.contains(fingerprint) &&
+            expansion->seen.insert(fingerprint).second) {
+          count++;
+        }
+      }
+      steps_still_for_state_add_remove_dust_lanes(level->batch.data(), count);
+      expansion->neighbours.insert(expansion->neighbours.end(),
+                                   level->batch.begin(),
+                                   level->batch.begin() + count);
+    }
+  };
+
+  auto start_time = std::chrono::steady_clock::now();
+  while (states_checked < max_states_to_check && !frontier.empty()) {
+    expansions.resize(std::min((size_t)width, frontier.size()));
+    for (auto &expansion : expansions) {
+      expansion.from = frontier.pop_max();
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        for (size_t e = t; e < expansions.size(); e += num_threads) {
+          expand(levels[t].get(), &expansions[e]);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    // the frontier and visited are only touched here, in the same order every
+    // time, so the first expansion to reach a shared neighbour keeps it
+    for (const auto &expansion : expansions) {
+      for (const auto &neighbour : expansion.neighbours) {
+        if (!visited.insert(neighbour.dust_frames.fingerprint())) {
+          continue;
+        }
+        int length = neighbour.length;
+        states_checked += 1;
+        found_per_length[length].fetch_add(1, std::memory_order_relaxed);
+        if (length == max_still_frames) {
+          report_still_whole_time(neighbour.dust_frames);
+        }
+        if (length > best.length) {
+          best = {neighbour.dust_frames, length, 0};
+          most_frames_lasted = length;
+          double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start_time)
+                               .count();
+          printf("new best = %d, states_checked = %ld, %.2f seconds in, "
+                 "expanding from %d\n",
+                 length, states_checked.load(), seconds, expansion.from.length);
+          print_found_per_length();
+          print_waiting_frames(best.dust_frames);
+          printf("   lasted %d\n\n", length);
+        }
+        frontier.push({neighbour.dust_frames, length,
+                       dust_plan_distance(neighbour.dust_frames,
+                                          best.dust_frames)});
+      }
+    }
   }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  printf("checked %ld states in %.2f seconds (%.0f states/sec), "
+         "most_frames_lasted overall = %d\n",
+         states_checked.load(), seconds, states_checked.load() / seconds,
+         most_frames_lasted.load());
 }
 
-// pick a random state for each search and find a new state with a small random
-// change to that state
-void runsimulation_randomstates() {
-  printf("Running\n");
-  // initialize_rand();
-  objects_t *currentstartingarray =
-      (objects_t *)malloc(sizeof(*currentstartingarray));
-  memset(currentstartingarray, 0, sizeof(objects_t));
-  while (true) {
-    randomizearray(currentstartingarray);
-    auto p = steps_still_for_state(currentstartingarray);
-    int length = p.first;
-    int seed_idx = p.second;
-    most_frames_lasted = std::max(length, most_frames_lasted);
-    states_checked += 1;
-    printf("checking top level, best so far is %d, states checked is %ld, "
-           "seed_idx = %d\n",
-           most_frames_lasted, states_checked, seed_idx);
-    check_small_changes(length, currentstartingarray, 0, 1, seed_idx);
+/* Robust plans. The state at the start of the window is never exactly the one
+in initial_state on real hardware, the rng can be a few calls off and the
+window can start a few frames late. So a robust plan is scored against a set
+of snapshots, initial_state with the rng moved every offset in
+[-rng_offsets, rng_offsets] and started every delay in [0, frame_offsets], by
+the shortest and the mean still period over all of them. All the snapshots of
+a batch of plans are one batch on the lane kernel, split between threads, so K
+snapshots cost about K times the states but not K times the overhead. */
+std::vector<objects_t> robust_snapshots;
+
+void make_robust_snapshots(int rng_offsets, int frame_offsets) {
+  objects_t delayed = initial_state;
+  for (int frame = 0; frame <= frame_offsets; frame++) {
+    int rng_index = rng_value_to_index[delayed.rngValue];
+    for (int offset = -rng_offsets; offset <= rng_offsets; offset++) {
+      if (offset != 0 && rng_index < 0) {
+        continue; // off the cycle there is no going back
+      }
+      objects_t snapshot = delayed;
+      if (offset != 0) {
+        snapshot.rngValue =
+            rng_index_to_value[(rng_index + offset + rng_cycle_length) %
+                               rng_cycle_length];
+      }
+      robust_snapshots.push_back(snapshot);
+    }
+    advanceobjects(&delayed);
   }
-  free(currentstartingarray);
 }
 
-void print_waiting_frames(const std::vector<bool> &dust_frames) {
-  printf("\rdust vector is:");
-  for (auto dust : dust_frames) {
-    if (dust) {
-      printf("+");
-    } else {
-      printf("-");
+typedef struct robust_score_t {
+  int min;
+  double mean;
+} robust_score_t;
+
+bool more_robust(const robust_score_t &a, const robust_score_t &b) {
+  return a.min > b.min || (a.min == b.min && a.mean > b.mean);
+}
+
+/* scores count plans against every snapshot, batch is reused between calls */
+void robust_scores(const dust_plan_t *plans, size_t count, int num_threads,
+                   std::vector<dust_candidate_t> &batch,
+                   robust_score_t *scores) {
+  const size_t k = robust_snapshots.size();
+  batch.resize(count * k);
+  for (size_t p = 0; p < count; p++) {
+    for (size_t s = 0; s < k; s++) {
+      dust_candidate_t &c = batch[p * k + s];
+      c.dust_frames = plans[p];
+      c.state = robust_snapshots[s];
+      c.dust_frame_to_start_with = 0;
+      c.parent = nullptr;
     }
   }
+  steps_still_for_state_add_remove_dust_threaded(batch.data(), batch.size(),
+                                                 num_threads);
+  for (size_t p = 0; p < count; p++) {
+    int min = max_still_frames;
+    long sum = 0;
+    for (size_t s = 0; s < k; s++) {
+      min = std::min(min, batch[p * k + s].length);
+      sum += batch[p * k + s].length;
+    }
+    scores[p] = {min, (double)sum / k};
+  }
 }
 
-int steps_still_for_state_add_remove_dust(std::vector<bool> &dust_frames,
-                                          objects_t &states,
-                                          size_t dust_frame_to_start_with) {
-  // wait some amount of frames making dust for some portion of them
-  for (size_t i = dust_frame_to_start_with; i < dust_frames.size(); i++) {
-    advanceobjects(&states);
-    if (dust_frames[i]) {
-      pollRNG(&states.rngValue);
-      pollRNG(&states.rngValue);
-      pollRNG(&states.rngValue);
-      pollRNG(&states.rngValue);
+/* Climbs to a robust plan from the starting dust vector, going to the most
+robust neighbour each step until none of them beats the current plan. */
+void runsimulation_robust(int rng_offsets, int frame_offsets,
+                          int num_threads) {
+  make_robust_snapshots(rng_offsets, frame_offsets);
+  printf("Running robust search against %zu snapshots (rng offsets up to %d, "
+         "frame offsets up to %d) on %d threads\n",
+         robust_snapshots.size(), rng_offsets, frame_offsets, num_threads);
+  std::vector<dust_candidate_t> batch;
+  dust_plan_t best = read_vector_from_string(starting_dust_frames);
+  robust_score_t best_score;
+  robust_scores(&best, 1, num_threads, batch, &best_score);
+  auto print_best = [&]() {
+    printf("min = %d, mean = %.2f, states_checked = %ld\n", best_score.min,
+           best_score.mean, states_checked.load());
+    print_waiting_frames(best);
+    printf("   lasted");
+    for (const auto &snapshot : batch) {
+      printf(" %d", snapshot.length);
+    }
+    printf("\n\n");
+  };
+  printf("start is ");
+  print_best();
+
+  fingerprint_set visited(24);
+  visited.insert(best.fingerprint());
+  std::unique_ptr<dust_search_level_t> level(new dust_search_level_t);
+  std::vector<dust_plan_t> neighbours;
+  std::vector<robust_score_t> scores;
+  while (states_checked < max_states_to_check) {
+    neighbours.clear();
+    start_dust_level(level.get(), best);
+    dust_candidate_t candidate;
+    while (next_dust_neighbour(level.get(), &candidate)) {
+      if (visited.insert(candidate.dust_frames.fingerprint())) {
+        neighbours.push_back(candidate.dust_frames);
+      }
     }
+    scores.resize(neighbours.size());
+    size_t best_neighbour = neighbours.size();
+    robust_score_t best_neighbour_score = best_score;
+    for (size_t first = 0; first < neighbours.size();
+         first += dust_batch_size) {
+      size_t count = std::min(dust_batch_size, neighbours.size() - first);
+      robust_scores(&neighbours[first], count, num_threads, batch,
+                    &scores[first]);
+      states_checked += count;
+      for (size_t i = first; i < first + count; i++) {
+        found_per_length[scores[i].min].fetch_add(1,
+                                                  std::memory_order_relaxed);
+        if (more_robust(scores[i], best_neighbour_score)) {
+          best_neighbour = i;
+          best_neighbour_score = scores[i];
+        }
+      }
+    }
+    if (best_neighbour == neighbours.size()) {
+      printf("no neighbour is more robust\n");
+      break;
+    }
+    best = neighbours[best_neighbour];
+    best_score = best_neighbour_score;
+    robust_scores(&best, 1, num_threads, batch, &best_score);
+    printf("new best ");
+    print_best();
   }
-  states.rcpscog.small_enough_movement_so_far = 1;
-  // if the target is bad skip this state
-  if (states.rcpscog.targetAngularVelocity > 200 ||
-      states.rcpscog.targetAngularVelocity < -200) {
-    states.rcpscog.small_enough_movement_so_far = 0;
-    return 0;
+}
+
+/* A temporary file of fixed size records, written by appending and read back
+by index. Frontiers in the exact search can be far bigger than memory, so they
+only ever pass through it a chunk at a time. */
+template <typename record_t> class spill_file {
+public:
+  spill_file() : file(tmpfile()) {
+    if (file == nullptr) {
+      perror("tmpfile");
+      exit(1);
+    }
   }
-  // if the target is good, but the current is bad, wait until it is good, and
-  // then try that
-  while (states.rcpscog.currentAngularVelocity > 200 ||
-         states.rcpscog.currentAngularVelocity < -200) {
-    advanceobjects(&states);
-    dust_frames.push_back(false);
+  ~spill_file() { fclose(file); }
+  spill_file(const spill_file &) = delete;
+  spill_file &operator=(const spill_file &) = delete;
+
+  void append(const record_t *records, size_t count) {
+    if (fseeko(file, 0, SEEK_END) != 0 ||
+        fwrite(records, sizeof(record_t), count, file) != count) {
+      perror("writing spill file");
+      exit(1);
+    }
+    records_written += count;
   }
 
-  int a = 0;
-  for (a = 0; a < 1200; a++) {
-    advanceobjects(&states);
-    // printobjectstates(&states);
-    if (states.rcpscog.small_enough_movement_so_far == 0) {
-      return a;
+  // returns how many records were read, fewer than count at the end
+  size_t read(size_t first, record_t *records, size_t count) {
+    if (fseeko(file, (off_t)(first * sizeof(record_t)), SEEK_SET) != 0) {
+      perror("reading spill file");
+      exit(1);
     }
+    return fread(records, sizeof(record_t), count, file);
   }
 
-  if (states.rcpscog.small_enough_movement_so_far == 1) {
-    printf("cog was still the whole time !!!\n");
-    print_waiting_frames(dust_frames);
-    printf("\n");
-    exit(0);
+  size_t size() const { return records_written; }
+
+private:
+  FILE *file;
+  size_t records_written = 0;
+};
+
+// frontier states go through memory this many at a time
+const size_t exact_chunk_states = 1 << 14;
+
+/* Finds the best dust vector of every length up to max_frames, instead of
+searching around one like runsimulation_add_remove_dust. All 2^n vectors of n
+frames are covered by going forward one frame at a time, with and without
+dust, and merging vectors that end up in the same state, since from then on
+they can only do the same. The frontier of distinct states still grows about
+1.5x a frame (7.5 million at frame 29), so this only gets so far.
+
+Each frontier lives in a spill_file, along with where each of its states came
+from so the best vector can be read back. Only a chunk of it and the set of
+fingerprints for the next frontier are ever in memory. Every state in a
+frontier is also evaluated as the end of a window, on the lane kernel.
+
+Nothing is pruned along the way. rcpscog only ever sets a target within
++-200, so a state whose target is still out of range can get a good one later
+and is kept until the end like any other. */
+void runsimulation_exact(int max_frames, int num_threads) {
+  max_frames = std::min(max_frames, (int)max_dust_frames);
+  printf("Running exact search up to %d frames\n", max_frames);
+  stat_timer_scope_t timer(time_bookkeeping);
+  std::unique_ptr<work_stealing_pool> pool;
+  if (num_threads > 0) {
+    printf("Running on %d threads\n", num_threads);
+    pool.reset(new work_stealing_pool(num_threads));
   }
+  // where each state in the frontier of frame f + 1 came from, as the index
+  // of its state in frame f's frontier times 2, plus 1 if it made dust
+  std::vector<std::unique_ptr<spill_file<uint32_t>>> parents;
+  auto frontier = std::make_unique<spill_file<objects_t>>();
+  objects_t starting_state = initial_state;
+  frontier->append(&starting_state, 1);
 
-  return a;
+  typedef struct slice_t {
+    size_t first, count;
+    std::vector<objects_t> children;
+    std::vector<uint32_t> child_parents;
+    int best_length;
+    size_t best_index;
+    int best_slowing_frames;
+  } slice_t;
+  size_t num_slices = std::max(num_threads, 1);
+  std::vector<slice_t> slices(num_slices);
+  std::vector<objects_t> chunk(exact_chunk_states);
+  std::vector<dust_candidate_t> candidates(exact_chunk_states);
+  auto start_time = std::chrono::steady_clock::now();
+
+  for (int frame = 0;; frame++) {
+    bool expand = frame < max_frames;
+    auto next = std::make_unique<spill_file<objects_t>>();
+    auto next_parents = std::make_unique<spill_file<uint32_t>>();
+    int log2_capacity = 10;
+    while ((size_t(1) << log2_capacity) < 4 * frontier->size()) {
+      log2_capacity++;
+    }
+    fingerprint_set seen(expand ? log2_capacity : 0);
+    int best_length = -1;
+    size_t best_index = 0;
+    int best_slowing_frames = 0;
+
+    for (size_t first = 0; first < frontier->size();
+         first += exact_chunk_states) {
+      size_t count = frontier->read(first, chunk.data(), exact_chunk_states);
+      auto run_slice = [&](slice_t &slice) {
+        dust_candidate_t *c = &candidates[slice.first];
+        for (size_t i = 0; i < slice.count; i++) {
+          c[i].dust_frames = dust_plan_t{};
+          c[i].state = chunk[slice.first + i];
+          c[i].dust_frame_to_start_with = 0;
+          c[i].parent = nullptr;
+        }
+        steps_still_for_state_add_remove_dust_lanes(c, slice.count);
+        slice.best_length = -1;
+        for (size_t i = 0; i < slice.count; i++) {
+          if (c[i].length > slice.best_length) {
+            slice.best_length = c[i].length;
+            slice.best_index = first + slice.first + i;
+            slice.best_slowing_frames = c[i].dust_frames.size();
+          }
+        }
+        slice.children.clear();
+        slice.child_parents.clear();
+        if (!expand) {
+          return;
+        }
+        stat_timer_scope_t timer(time_making_neighbours);
+        objects_lanes_t lanes = {};
+        for (size_t i = 0; i < slice.count; i++) {
+          objects_t child = chunk[slice.first + i];
+          advanceobjects(&child);
+          for (int dust = 0; dust < 2; dust++) {
+            if (dust) {
+              advanceRNG(&child.rngValue, 4);
+            }
+            set_lane(&lanes, 0, child);
+            if (seen.insert(lane_state_hash(&lanes, 0))) {
+              slice.children.push_back(child);
+              slice.child_parents.push_back(
+                  (uint32_t)((first + slice.first + i) * 2 + dust));
+            }
+          }
+        }
+      };
+      for (size_t i = 0; i < num_slices; i++) {
+        slices[i].first = count * i / num_slices;
+        slices[i].count = count * (i + 1) / num_slices - slices[i].first;
+        if (pool) {
+          pool->submit([&run_slice, &slice = slices[i]] { run_slice(slice); });
+        } else {
+          run_slice(slices[i]);
+        }
+      }
+      if (pool) {
+        pool->wait_until_idle();
+      }
+      // the slices go in in order, so the frontier only depends on the threads
+      // through which of two equal states is kept, and which rare duplicates
+      // get past a crowded fingerprint_set
+      for (auto &slice : slices) {
+        if (slice.best_length > best_length) {
+          best_length = slice.best_length;
+          best_index = slice.best_index;
+          best_slowing_frames = slice.best_slowing_frames;
+        }
+        next->append(slice.children.data(), slice.children.size());
+        next_parents->append(slice.child_parents.data(),
+                             slice.child_parents.size());
+      }
+    }
+
+    // read the best vector back from the parents of its state
+    dust_plan_t best;
+    for (int i = 0; i < frame; i++) {
+      best.push_back(false);
+    }
+    size_t index = best_index;
+    for (int at = frame; at > 0; at--) {
+      uint32_t parent;
+      parents[at - 1]->read(index, &parent, 1);
+      best.set(at - 1, parent & 1);
+      index = parent >> 1;
+    }
+    for (int i = 0; i < best_slowing_frames && !best.full(); i++) {
+      best.push_back(false);
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start_time)
+                         .count();
+    printf("%d frames: %zu states, best lasted %d (%.2f seconds so far)\n",
+           frame, frontier->size(), best_length, seconds);
+    print_waiting_frames(best);
+    printf("\n");
+    if (best_length == max_still_frames) {
+      report_still_whole_time(best);
+    }
+    if (!expand) {
+      break;
+    }
+    if (next->size() >= (size_t(1) << 31)) {
+      printf("the frontier is too big to keep going\n");
+      break;
+    }
+    frontier = std::move(next);
+    parents.push_back(std::move(next_parents));
+  }
 }
-void check_small_changes_add_remove_dust(
-    int best_so_far, int steps_since_last_increase, int depth,
-    std::vector<std::pair<std::vector<bool>, size_t>> dust_frames_stack,
-    int bad_steps_allowed);
-
-void check_state_and_recurse_add_remove_dust(
-    int best_so_far, int steps_since_last_increase, int depth,
-    std::vector<bool> dust_frames,
-    std::vector<std::pair<std::vector<bool>, size_t>> dust_frames_stack,
-    int bad_steps_allowed, objects_t states, size_t dust_frame_to_start_with) {
-  // print_waiting_frames(dust_frames);
-  for (const auto &pair : dust_frames_stack) {
-    // this is already in the stack somewhere, just skip it
-    if (dust_frames == pair.first) {
-      return;
+
+/* Hands out the lines of a file or of stdin without copying them. A file is
+mapped, stdin is read a large chunk at a time and only the partial line at
+the end of a chunk is moved to the front. A line is good until the next one is
+asked for. */
+class line_reader_t {
+public:
+  explicit line_reader_t(const char *path) {
+    if (path != nullptr) {
+      fd = open(path, O_RDONLY);
+      if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        exit(1);
+      }
+      struct stat file_stat;
+      if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) &&
+          file_stat.st_size > 0) {
+        mapped_size = file_stat.st_size;
+        void *text = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text != MAP_FAILED) {
+          madvise(text, mapped_size, MADV_SEQUENTIAL);
+          pos = (const char *)text;
+          end = pos + mapped_size;
+          return;
+        }
+        mapped_size = 0;
+      }
     }
+    buffer.resize(1 << 20);
+    pos = end = buffer.data();
   }
-  int length = steps_still_for_state_add_remove_dust(dust_frames, states,
-                                                     dust_frame_to_start_with);
-  found_per_length[length]++;
-  states_checked += 1;
-  if (length > best_so_far) {
-    most_frames_lasted = std::max(most_frames_lasted, length);
-    dust_frames_stack.emplace_back(dust_frames, length);
-    if (length > most_frames_lasted - 5) {
-      // extra confirm
-      if (false) {
-        objects_t state_check;
-        int check_length =
-            steps_still_for_state_add_remove_dust(dust_frames, state_check, 0);
-        if (check_length != length) {
-          printf("something is wrong\n");
+
+  ~line_reader_t() {
+    if (mapped_size != 0) {
+      munmap((void *)(end - mapped_size), mapped_size);
+    }
+    if (fd > 0) {
+      close(fd);
+    }
+  }
+
+  bool next(const char **line, size_t *length) {
+    while (true) {
+      const char *newline = (const char *)memchr(pos, '\n', end - pos);
+      if (newline != nullptr || mapped_size != 0 || at_eof) {
+        if (newline == nullptr && pos == end) {
+          return false;
         }
+        const char *line_end = newline != nullptr ? newline : end;
+        *line = pos;
+        *length = line_end - pos;
+        if (*length > 0 && line_end[-1] == '\r') {
+          (*length)--;
+        }
+        pos = newline != nullptr ? newline + 1 : end;
+        return true;
       }
-      printf("new best on path = %d, states_checked = %ld, "
-             "depth = %d, most_frames_lasted overall = %d\n",
-             length, states_checked, depth, most_frames_lasted);
+      refill();
+    }
+  }
+
+private:
+  void refill() {
+    size_t left = end - pos;
+    if (left == buffer.size()) { // a line longer than the whole buffer
+      std::vector<char> bigger(2 * buffer.size());
+      memcpy(bigger.data(), pos, left);
+      buffer.swap(bigger);
+    } else {
+      memmove(buffer.data(), pos, left);
+    }
+    ssize_t got = read(fd, buffer.data() + left, buffer.size() - left);
+    if (got <= 0) {
+      at_eof = true;
+      got = 0;
+    }
+    pos = buffer.data();
+    end = pos + left + got;
+  }
+
+  int fd = 0; // stdin
+  size_t mapped_size = 0;
+  std::vector<char> buffer;
+  const char *pos;
+  const char *end;
+  bool at_eof = false;
+};
+
+/* reads a number at p, moving p past it */
+bool parse_number(const char *&p, const char *end, long *value) {
+  const char *digits = p;
+  *value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    *value = *value * 10 + (*p++ - '0');
+  }
+  return p != digits;
+}
 
-      for (const auto &pair : found_per_length) {
-        printf("{%lu, %lu}, ", pair.first, pair.second);
+/* A line is a dust vector, optionally followed by rng=<value> to start from
+that rng value, or state=<n> to start from the nth of the snapshots. Returns
+false if it is neither. */
+bool parse_eval_line(const char *line, size_t length,
+                     const std::vector<objects_t> &snapshots,
+                     dust_candidate_t *candidate) {
+  const char *p = line;
+  const char *end = line + length;
+  candidate->dust_frames = dust_plan_t{};
+  candidate->state = snapshots[0];
+  candidate->dust_frame_to_start_with = 0;
+  candidate->parent = nullptr;
+  for (; p < end && (*p == '+' || *p == '-'); p++) {
+    if (candidate->dust_frames.full()) {
+      return false;
+    }
+    candidate->dust_frames.push_back(*p == '+');
+  }
+  long rng = -1;
+  while (p < end) {
+    if (*p == ' ' || *p == '\t') {
+      p++;
+      continue;
+    }
+    long value;
+    if (end - p > 4 && memcmp(p, "rng=", 4) == 0) {
+      p += 4;
+      if (!parse_number(p, end, &rng) || rng > 0xFFFF) {
+        return false;
       }
-      printf("\n");
-      printf("path we took to get here\n");
-      for (const auto &pair : dust_frames_stack) {
-        print_waiting_frames(pair.first);
-        printf("   lasted %zu\n", pair.second);
+    } else if (end - p > 6 && memcmp(p, "state=", 6) == 0) {
+      p += 6;
+      if (!parse_number(p, end, &value) || value >= (long)snapshots.size()) {
+        return false;
       }
-      printf("\n");
+      candidate->state = snapshots[value];
+    } else {
+      return false;
     }
-    check_small_changes_add_remove_dust(length, 0, depth + 1, dust_frames_stack,
-                                        bad_steps_allowed);
-    // } else if (length == best_so_far && length > 50) {
-    //   most_frames_lasted = std::max(most_frames_lasted, length);
-    //   if (length > most_frames_lasted - 5) {
-    //     print_waiting_frames(dust_frames);
-    //     printf("\nmatching best on path = %d, states_checked = %ld, "
-    //            "depth = %d, most_frames_lasted overall = %d\n",
-    //            length, states_checked, depth, most_frames_lasted);
-    //     for (const auto &pair : found_per_length) {
-    //       printf("{%lu, %lu}, ", pair.first, pair.second);
-    //     }
-    //     printf("\n");
-    //   }
-    //   dust_frames_stack.emplace_back(dust_frames, length);
-    //   check_small_changes_add_remove_dust(length, steps_since_last_increase +
-    //   1,
-    //                                       depth + 1, dust_frames_stack,
-    //                                       bad_steps_allowed);
-  } else if (steps_since_last_increase < bad_steps_allowed) {
-    dust_frames_stack.emplace_back(dust_frames, length);
-    check_small_changes_add_remove_dust(
-        best_so_far, steps_since_last_increase + 1, depth + 1,
-        dust_frames_stack, bad_steps_allowed);
   }
+  if (rng >= 0) {
+    candidate->state.rngValue = rng;
+  }
+  return true;
 }
 
-static long max_states_to_check = std::numeric_limits<int64_t>::max();
+// plans handed to a worker at a time, and how many batches can be in flight
+// (being evaluated or waiting for an earlier one to be written) per thread
+const size_t eval_batch_plans = 4096;
+const int eval_batches_per_thread = 2;
+
+typedef struct eval_batch_t {
+  std::vector<dust_candidate_t> candidates;
+  std::vector<char> parsed;
+  size_t count = 0;
+  bool in_flight = false;
+  bool done = false; // guarded by the eval mutex
+} eval_batch_t;
+
+/* Scores dust plans read one per line from a file, or from stdin if path is
+null, and writes each one's length to stdout in the same order, -1 for a line
+that isn't a plan. Lines are parsed straight out of the input into batches,
+the batches are evaluated on the pool, and a fixed ring of them is the reorder
+buffer: a batch is only refilled once it has been written, so no more than
+the ring's worth of plans are ever held, however far ahead the reading gets. */
+void runsimulation_eval(const char *path, const std::vector<objects_t> &snapshots,
+                        int num_threads) {
+  auto start_time = std::chrono::steady_clock::now();
+  line_reader_t reader(path);
+  std::unique_ptr<work_stealing_pool> pool;
+  if (num_threads > 1) {
+    pool.reset(new work_stealing_pool(num_threads));
+  }
+  std::vector<eval_batch_t> ring(eval_batches_per_thread * num_threads);
+  std::mutex mutex;
+  std::condition_variable batch_done;
+  std::vector<char> out;
+  long plans = 0;
+  size_t submitted = 0;
+  size_t written = 0;
+
+  auto evaluate = [](eval_batch_t *batch) {
+    steps_still_for_state_add_remove_dust_lanes(batch->candidates.data(),
+                                                batch->count);
+  };
+  // waits for the oldest batch in flight and writes it out
+  auto write_oldest = [&]() {
+    eval_batch_t &batch = ring[written % ring.size()];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      batch_done.wait(lock, [&batch] { return batch.done; });
+    }
+    out.clear();
+    char number[16];
+    for (size_t i = 0; i < batch.count; i++) {
+      int length = batch.parsed[i] ? batch.candidates[i].length : -1;
+      int n = snprintf(number, sizeof(number), "%d\n", length);
+      out.insert(out.end(), number, number + n);
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    batch.in_flight = false;
+    written++;
+  };
 
-void check_small_changes_add_remove_dust(
-    int best_so_far, int steps_since_last_increase, int depth,
-    std::vector<std::pair<std::vector<bool>, size_t>> dust_frames_stack,
-    int bad_steps_allowed) {
-  // // just for helping compare optimizations
-  if (states_checked >= max_states_to_check) {
-    exit(0);
+  while (true) {
+    eval_batch_t &batch = ring[submitted % ring.size()];
+    if (batch.in_flight) {
+      write_oldest();
+    }
+    batch.candidates.resize(eval_batch_plans);
+    batch.parsed.resize(eval_batch_plans);
+    batch.count = 0;
+    const char *line;
+    size_t length;
+    while (batch.count < eval_batch_plans && reader.next(&line, &length)) {
+      batch.parsed[batch.count] = parse_eval_line(
+          line, length, snapshots, &batch.candidates[batch.count]);
+      batch.count++;
+    }
+    if (batch.count == 0) {
+      break;
+    }
+    plans += batch.count;
+    batch.in_flight = true;
+    batch.done = false;
+    submitted++;
+    if (!pool) {
+      evaluate(&batch);
+      batch.done = true;
+      write_oldest();
+      continue;
+    }
+    pool->submit([&, batch_ptr = &batch] {
+      evaluate(batch_ptr);
+      std::lock_guard<std::mutex> lock(mutex);
+      batch_ptr->done = true;
+      batch_done.notify_all();
+    });
+  }
+  while (written < submitted) {
+    write_oldest();
   }
+  fflush(stdout);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  fprintf(stderr, "evaluated %ld plans in %.2f seconds (%.0f plans/sec)\n",
+          plans, seconds, plans / seconds);
+}
+
+/* The C API in rcps.h. A context is a transposition table of its own, the
+state plans start from and the candidates a batch is copied into, which are
+kept between calls. Nothing here touches the globals the searches use, and
+nothing exits or lets an exception out to a C caller. */
+static_assert(sizeof(objects_t) == RCPS_STATE_SIZE,
+              "RCPS_STATE_SIZE in rcps.h is out of date");
+
+// plans copied in and evaluated at a time, so a huge batch needs no more memory
+const size_t library_chunk_plans = 16384;
+
+struct rcps_context {
+  explicit rcps_context(int num_threads)
+      : num_threads(std::max(num_threads, 1)), table(20) {}
+
+  int num_threads;
+  transposition_table table;
   objects_t state;
-  std::vector<bool> dust_frames = dust_frames_stack.back().first;
-  // gotten from pannen as the starting rng seed, update if nessasary
-  for (size_t i = 0; i < dust_frames.size(); i++) {
-    // first try just swapping this frame
-    dust_frames[i] = !dust_frames[i];
-    check_state_and_recurse_add_remove_dust(
-        best_so_far, steps_since_last_increase, depth, dust_frames,
-        dust_frames_stack, bad_steps_allowed, state, i);
+  std::vector<dust_candidate_t> candidates;
+  std::vector<size_t> plan_index; // which plan each candidate is
+};
 
-    size_t biggest_move_size = 5;
+rcps_context *rcps_context_new(int num_threads) {
+  try {
+    return new rcps_context(num_threads);
+  } catch (const std::exception &) {
+    return nullptr;
+  }
+}
 
-    // then try moving a later frame to this frame
-    for (size_t j = i + 1;
-         j < std::min(dust_frames.size(), i + biggest_move_size); j++) {
-      // if its equal to the flipped value, then assume we moved the value
-      // and flip the other one
-      if (dust_frames[j] == dust_frames[i] && dust_frames[i]) {
-        dust_frames[j] = !dust_frames[j];
-        check_state_and_recurse_add_remove_dust(
-            best_so_far, steps_since_last_increase, depth, dust_frames,
-            dust_frames_stack, bad_steps_allowed, state, i);
-        dust_frames[j] = !dust_frames[j];
+void rcps_context_free(rcps_context *context) { delete context; }
+
+void rcps_context_set_state(rcps_context *context, const rcps_state *state) {
+  memcpy((void *)&context->state, state, sizeof(objects_t));
+}
+
+void rcps_context_clear(rcps_context *context) { context->table.clear(); }
+
+void rcps_default_state(rcps_state *state) {
+  objects_t default_state;
+  memcpy(state, &default_state, sizeof(objects_t));
+}
+
+int rcps_load_state(const char *path, rcps_state *state) {
+  objects_t loaded;
+  if (!load_stroop_state(path, &loaded)) {
+    return -1;
+  }
+  memcpy(state, &loaded, sizeof(objects_t));
+  return 0;
+}
+
+unsigned short rcps_state_rng(const rcps_state *state) {
+  unsigned short rng;
+  memcpy(&rng, state->bytes + offsetof(objects_t, rngValue), sizeof(rng));
+  return rng;
+}
+
+void rcps_state_set_rng(rcps_state *state, unsigned short rng) {
+  memcpy(state->bytes + offsetof(objects_t, rngValue), &rng, sizeof(rng));
+}
+
+/* rcps_simulate_batch, which may throw */
+int simulate_batch(rcps_context *context, const rcps_state *states,
+                   const rcps_plan *plans, size_t count, int *out_lengths) {
+  int rejected = 0;
+  std::vector<dust_candidate_t> &candidates = context->candidates;
+  std::vector<size_t> &plan_index = context->plan_index;
+  for (size_t first = 0; first < count; first += library_chunk_plans) {
+    size_t last = std::min(count, first + library_chunk_plans);
+    candidates.resize(last - first);
+    plan_index.clear();
+    for (size_t i = first; i < last; i++) {
+      if (plans[i].frames > max_dust_frames) {
+        out_lengths[i] = -1;
+        rejected++;
+        continue;
+      }
+      dust_candidate_t &c = candidates[plan_index.size()];
+      plan_index.push_back(i);
+      c.dust_frames = dust_plan_t{};
+      for (size_t frame = 0; frame < plans[i].frames; frame++) {
+        c.dust_frames.push_back(plans[i].dust[frame] != 0);
+      }
+      if (states != nullptr) {
+        memcpy((void *)&c.state, &states[i], sizeof(objects_t));
+      } else {
+        c.state = context->state;
       }
+      c.dust_frame_to_start_with = 0;
+      c.parent = nullptr;
     }
-    dust_frames[i] = !dust_frames[i];
-    advanceobjects(&state);
-    if (dust_frames[i]) {
-      pollRNG(&state.rngValue);
-      pollRNG(&state.rngValue);
-      pollRNG(&state.rngValue);
-      pollRNG(&state.rngValue);
+    steps_still_for_state_add_remove_dust_threaded(
+        candidates.data(), plan_index.size(), context->num_threads,
+        &context->table);
+    for (size_t j = 0; j < plan_index.size(); j++) {
+      out_lengths[plan_index[j]] = candidates[j].length;
     }
   }
-  // try adding a frame either way
-  dust_frames.push_back(true);
-  check_state_and_recurse_add_remove_dust(
-      best_so_far, steps_since_last_increase, depth, dust_frames,
-      dust_frames_stack, bad_steps_allowed, state, dust_frames.size());
-  dust_frames.pop_back();
-  dust_frames.push_back(false);
-  check_state_and_recurse_add_remove_dust(
-      best_so_far, steps_since_last_increase, depth, dust_frames,
-      dust_frames_stack, bad_steps_allowed, state, dust_frames.size());
-  dust_frames.pop_back();
-  // try removing a frame
-  bool back = dust_frames.back();
-  dust_frames.pop_back();
-  check_state_and_recurse_add_remove_dust(
-      best_so_far, steps_since_last_increase, depth, dust_frames,
-      dust_frames_stack, bad_steps_allowed, {}, 0);
-  dust_frames.push_back(back);
-  // leave it as you found it
-}
-std::vector<bool> read_vector_from_string(std::string frames) {
-  std::vector<bool> vec;
-  for (const auto &f : frames) {
-    if (f == '+') {
-      vec.push_back(true);
-    } else if (f == '-') {
-      vec.push_back(false);
-    } else {
-      printf("shouldn't happen\n");
-    }
+  return rejected;
+}
+
+int rcps_simulate_batch(rcps_context *context, const rcps_state *states,
+                        const rcps_plan *plans, size_t count,
+                        int *out_lengths) {
+  try {
+    return simulate_batch(context, states, plans, count, out_lengths);
+  } catch (const std::exception &) {
+    return -1;
   }
-  return vec;
 }
 
-// start with state, and a number of frames to stay wait
-// make a new state by changing a state from nothing to dust, dust to nothing,
-// or adding or removing a frame to wait
-void runsimulation_add_remove_dust(int frames_to_wait, int bad_steps_allowed) {
-  printf("Running\n");
-  // initialize_rand();
+#ifdef RCPS_BENCH
+/* The benchmarks, built with make bench. Every one starts gen from the same
+seed and does a fixed amount of work, so runs can be compared, and the results
+go to stdout as one JSON object. Allocations are counted by replacing the
+global operator new. */
 
-  std::vector<bool> dust_frames(frames_to_wait);
-  // for (size_t i = 0; i < dust_frames.size(); i++) {
-  //   dust_frames[i] = randbetween<0, 10>() == 0;
-  // }
-  dust_frames = read_vector_from_string(
-      "-----+------------+----------------+---------------------------------++-"
-      "-------+-+------------+--------+----+-+-------------+----+--------+-----"
-      "------------+-+-----------------------------------------");
-  while (true) {
+std::atomic<long> bench_allocations{0};
+
+void *operator new(size_t size) {
+  bench_allocations.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new(size_t size, std::align_val_t align) {
+  bench_allocations.fetch_add(1, std::memory_order_relaxed);
+  size_t alignment = (size_t)align;
+  void *p = aligned_alloc(alignment, (size + alignment - 1) / alignment *
+                                         alignment);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+// out of line, gcc warns about every delete once it sees the free in it
+__attribute__((noinline)) void bench_free(void *p) { free(p); }
+
+void operator delete(void *p) noexcept { bench_free(p); }
+void operator delete(void *p, size_t) noexcept { bench_free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { bench_free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+  bench_free(p);
+}
+
+const unsigned bench_seed = 20240229;
+volatile int bench_sink;
+bool bench_first = true;
+
+/* runs work, which returns how many units it did, and prints how long each
+took as one entry of the JSON list */
+template <typename work_t>
+void bench(const char *name, const char *unit, work_t work) {
+  gen.seed(bench_seed);
+  still_lengths.clear();
+  long allocations = bench_allocations.load();
+  auto start_time = std::chrono::steady_clock::now();
+  long units = work();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  allocations = bench_allocations.load() - allocations;
+  printf("%s\n    {\"name\": \"%s\", \"%ss\": %ld, \"seconds\": %.6f, "
+         "\"ns_per_%s\": %.3f, \"%ss_per_sec\": %.1f, \"allocations\": %ld}",
+         bench_first ? "" : ",", name, unit, units, seconds, unit,
+         seconds * 1e9 / units, unit, units / seconds, allocations);
+  fflush(stdout);
+  bench_first = false;
+}
+
+void run_benchmarks() {
+  printf("{\n  \"seed\": %u,\n  \"simd_lanes\": %d,\n  \"benchmarks\": [",
+         bench_seed, simd_lanes);
+  bench("pollRNG", "call", [] {
+    unsigned short rng = 0;
+    int sum = 0;
+    const long calls = 50000000;
+    for (long i = 0; i < calls; i++) {
+      sum += pollRNG(&rng);
+    }
+    bench_sink = sum;
+    return calls;
+  });
+  bench("advanceobjects", "frame", [] {
     objects_t state;
-    int length = steps_still_for_state_add_remove_dust(dust_frames, state, 0);
-    states_checked += 1;
-    printf("start is %d\n", length);
-    check_small_changes_add_remove_dust(length, 0, 1, {{dust_frames, length}},
-                                        bad_steps_allowed);
-    printf("finished seraching from the starting point, starting over\n");
-    dust_frames.clear();
-    for (size_t i = 0; i < dust_frames.size(); i++) {
-      dust_frames[i] = randbetween<0, 10>() == 0;
+    randomizearray(&state);
+    const long frames = 1000000;
+    for (long i = 0; i < frames; i++) {
+      // keep every object moving, a cog that moved too much stops the rest
+      state.rcpscog.small_enough_movement_so_far = 1;
+      advanceobjects(&state);
     }
+    bench_sink = state.rngValue;
+    return frames;
+  });
+  std::vector<pusher_t> pushers;
+  for (int i = 0; i < 400; i++) {
+    objects_t state;
+    randomizearray(&state);
+    pushers.insert(pushers.end(), state.pushers, state.pushers + 12);
   }
+  const long pusher_passes = 4000;
+  bench("pusher", "call", [&pushers, pusher_passes] {
+    std::vector<pusher_t> p = pushers;
+    unsigned short rng = 0;
+    for (long pass = 0; pass < pusher_passes; pass++) {
+      for (auto &pusher_state : p) {
+        pusher(&pusher_state, &rng);
+      }
+    }
+    bench_sink = rng + p[0].counter;
+    return pusher_passes * (long)p.size();
+  });
+  bench("pusher_full", "call", [&pushers, pusher_passes] {
+    std::vector<pusher_t> p = pushers;
+    unsigned short rng = 0;
+    for (long pass = 0; pass < pusher_passes; pass++) {
+      for (auto &pusher_state : p) {
+        pusher_full(&pusher_state, &rng);
+      }
+    }
+    bench_sink = rng + p[0].counter;
+    return pusher_passes * (long)p.size();
+  });
+  bench("steps_still_for_state", "sweep", [] {
+    objects_t state;
+    const long sweeps = 20;
+    int sum = 0;
+    for (long i = 0; i < sweeps; i++) {
+      randomizearray(&state);
+      sum += steps_still_for_state(&state).first;
+    }
+    bench_sink = sum;
+    return sweeps;
+  });
+  bench("dust_neighbourhood", "state", [] {
+    std::unique_ptr<dust_search_level_t> level(new dust_search_level_t);
+    level->batch.resize(dust_batch_size);
+    const dust_plan_t start = read_vector_from_string(starting_dust_frames);
+    long states = 0;
+    int sum = 0;
+    for (int repeat = 0; repeat < 50; repeat++) {
+      // every neighbour would be in the table the second time round
+      still_lengths.clear();
+      start_dust_level(level.get(), start);
+      while (level->stage != dust_search_level_t::done) {
+        size_t count = 0;
+        while (count < dust_batch_size &&
+               next_dust_neighbour(level.get(), &level->batch[count])) {
+          count++;
+        }
+        steps_still_for_state_add_remove_dust_lanes(level->batch.data(),
+                                                    count);
+        for (size_t i = 0; i < count; i++) {
+          sum += level->batch[i].length;
+        }
+        states += count;
+      }
+    }
+    bench_sink = sum;
+    return states;
+  });
+  // a new random state swept over every seed, then small changes to it
+  // checked around the best seed, like the random state search does
+  bench("randomstates_step", "step", [] {
+    objects_t state;
+    const long steps = 10;
+    int sum = 0;
+    for (long step = 0; step < steps; step++) {
+      randomizearray(&state);
+      int seed_idx = steps_still_for_state(&state).second;
+      for (int change = 0; change < 100; change++) {
+        auto &block = state.rotating_blocks[change % 6];
+        auto saved = block.remaining_time;
+        block.remaining_time = randbetween(0, 165);
+        sum += steps_still_for_state(&state, seed_idx).first;
+        block.remaining_time = saved;
+      }
+    }
+    bench_sink = sum;
+    return steps;
+  });
+  printf("\n  ]\n}\n");
+}
+
+int main() {
+  run_benchmarks();
+  return 0;
+}
+#elif !defined(RCPS_LIBRARY)
+void print_usage() {
+  printf("usage\n./rcps <waiting frames> <bad steps allowed> "
+         "[max states to check] [--threads N]\n"
+         "./rcps --anneal <waiting frames> [max states to check] "
+         "[--threads N]\n"
+         "./rcps --genetic <waiting frames> [max states to check] "
+         "[--threads N]\n"
+         "./rcps --beam <width> [max states to check] [--threads N]\n"
+         "./rcps --exact <max waiting frames> [--threads N]\n"
+         "./rcps --robust <rng offsets>[,<frame offsets>] [max states to "
+         "check] [--threads N]\n"
+         "./rcps --rng-trace <dust vector>\n"
+         "./rcps --eval [file of dust vectors, stdin if not given] "
+         "[--state <directory of STROOP files>] [--threads N]\n"
+         "./rcps --analyse <dust vector> [rng offsets] [--threads N]\n"
+         "./rcps --state <directory of STROOP files> [--threads N]\n"
+         "any of them take --state <STROOP file> to start from it instead of "
+         "the state built in\n"
+         "any of them take --stats N to print counters to stderr every N "
+         "seconds, in a build made with make STATS=1\n");
+  exit(1);
 }
 
 int main(int argc, char *argv[]) {
-  // for (int i = 0; i < num_seeds; i++) {
-  //   rngSeeds[i] = pollRNG(rngValue);
-  // }
-  if (argc == 1){
-    runsimulation_randomstates();
+  // pull out the --flags, what is left are the positional arguments
+  int num_threads = 0;
+  int exact_frames = -1;
+  bool anneal = false;
+  bool genetic = false;
+  int beam_width = 0;
+  int stats_interval = 0;
+  const char *rng_trace = nullptr;
+  const char *state_path = nullptr;
+  const char *robust = nullptr;
+  const char *analyse = nullptr;
+  bool eval = false;
+  int positional = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--anneal") == 0) {
+      anneal = true;
+    } else if (strcmp(argv[i], "--genetic") == 0) {
+      genetic = true;
+    } else if (strcmp(argv[i], "--beam") == 0 && i + 1 < argc) {
+      beam_width = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--exact") == 0 && i + 1 < argc) {
+      exact_frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+      stats_interval = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--rng-trace") == 0 && i + 1 < argc) {
+      rng_trace = argv[++i];
+    } else if (strcmp(argv[i], "--state") == 0 && i + 1 < argc) {
+      state_path = argv[++i];
+    } else if (strcmp(argv[i], "--robust") == 0 && i + 1 < argc) {
+      robust = argv[++i];
+    } else if (strcmp(argv[i], "--analyse") == 0 && i + 1 < argc) {
+      analyse = argv[++i];
+    } else if (strcmp(argv[i], "--eval") == 0) {
+      eval = true;
+    } else {
+      argv[positional++] = argv[i];
+    }
+  }
+  argc = positional;
+  if (stats_interval > 0) {
+#ifndef RCPS_STATS
+    fprintf(stderr, "--stats needs a build made with make STATS=1\n");
+    exit(1);
+#endif
+    start_stats_reporter(stats_interval);
+  }
+#ifdef RCPS_TELEMETRY
+  atexit(object_telemetry_t::print);
+  at_quick_exit(object_telemetry_t::print);
+#endif
+  // --eval can pick any of the snapshots in a --state directory by number
+  std::vector<objects_t> snapshots;
+  if (state_path != nullptr) {
+    struct stat path_stat;
+    bool is_directory =
+        stat(state_path, &path_stat) == 0 && S_ISDIR(path_stat.st_mode);
+    if (is_directory && !eval) {
+      sweep_stroop_directory(state_path, std::max(num_threads, 1));
+      return 0;
+    }
+    if (is_directory) {
+      for (const auto &name : stroop_file_names(state_path)) {
+        std::string path = std::string(state_path) + "/" + name;
+        snapshots.emplace_back();
+        if (!load_stroop_state(path.c_str(), &snapshots.back())) {
+          exit(1);
+        }
+      }
+      if (!snapshots.empty()) {
+        initial_state = snapshots[0];
+      }
+    } else if (!load_stroop_state(state_path, &initial_state)) {
+      exit(1);
+    }
+  }
+  if (snapshots.empty()) {
+    snapshots.push_back(initial_state);
+  }
+  if (eval) {
+    runsimulation_eval(argc >= 2 && strcmp(argv[1], "-") != 0 ? argv[1]
+                                                              : nullptr,
+                       snapshots, std::max(num_threads, 1));
+  } else if (rng_trace != nullptr) {
+    print_rng_trace(read_vector_from_string(rng_trace));
+  } else if (analyse != nullptr) {
+    int rng_offsets = argc >= 2 ? atoi(argv[1]) : 8;
+    analyse_plan(read_vector_from_string(analyse), rng_offsets,
+                 std::max(num_threads, 1));
+  } else if (robust != nullptr) {
+    int rng_offsets = 0;
+    int frame_offsets = 0;
+    if (sscanf(robust, "%d,%d", &rng_offsets, &frame_offsets) < 1 ||
+        rng_offsets < 0 || frame_offsets < 0) {
+      print_usage();
+    }
+    if (argc >= 2) {
+      max_states_to_check = atol(argv[1]);
+    }
+    runsimulation_robust(rng_offsets, frame_offsets, std::max(num_threads, 1));
+  } else if (exact_frames >= 0) {
+    runsimulation_exact(exact_frames, num_threads);
+  } else if (beam_width > 0) {
+    if (argc >= 2) {
+      max_states_to_check = atol(argv[1]);
+    }
+    runsimulation_beam(beam_width, std::max(num_threads, 1));
+  } else if (anneal || genetic) {
+    if (argc < 2) {
+      print_usage();
+    }
+    if (argc >= 3) {
+      max_states_to_check = atol(argv[2]);
+    }
+    if (anneal) {
+      runsimulation_anneal(atoi(argv[1]), num_threads > 0 ? num_threads : 4);
+    } else {
+      runsimulation_genetic(atoi(argv[1]), std::max(num_threads, 1));
+    }
+  } else if (argc == 1){
+    runsimulation_randomstates(std::max(num_threads, 1));
   } else{
     if (argc < 3) {
-    printf("usage\n./rcps <waiting frames> <bad steps allowed>\n");
-    exit(1);
+    print_usage();
   }
   int frames_to_wait = atoi(argv[1]);
   int bad_steps = atoi(argv[2]);
   if (argc == 4) {
     max_states_to_check = atol(argv[3]);
   }
-  runsimulation_add_remove_dust(frames_to_wait, bad_steps);
+  if (num_threads > 0) {
+    runsimulation_add_remove_dust_threaded(frames_to_wait, bad_steps,
+                                           num_threads);
+  } else {
+    runsimulation_add_remove_dust(frames_to_wait, bad_steps);
+  }
   }
   return 0;
-}
\ No newline at end of file
+}
+#endif
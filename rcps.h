@@ -0,0 +1,74 @@
+/* The simulator as a library, built with make librcps.so. Everything is
+reached through a context, which owns its own transposition table and
+buffers, so contexts don't share anything and each can be driven from its own
+thread. One context must not be used from two threads at once.
+
+From Python:
+  lib = ctypes.CDLL("./librcps.so")
+  ctx = lib.rcps_context_new(4)
+  plans = (rcps_plan * n)(...)       # dust as bytes, nonzero is dust
+  lengths = (ctypes.c_int * n)()
+  lib.rcps_simulate_batch(ctx, None, plans, n, lengths)
+  lib.rcps_context_free(ctx) */
+#ifndef RCPS_H
+#define RCPS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RCPS_API __attribute__((visibility("default")))
+
+// the bytes of a simulator state, only ever copied, never looked into
+#define RCPS_STATE_SIZE 320
+typedef struct rcps_state {
+  unsigned char bytes[RCPS_STATE_SIZE];
+} rcps_state;
+
+// a dust vector, frame i has dust if dust[i] is nonzero
+typedef struct rcps_plan {
+  const unsigned char *dust;
+  size_t frames;
+} rcps_plan;
+
+typedef struct rcps_context rcps_context;
+
+/* a context that evaluates on num_threads threads (1 if less), starting from
+the state in state.txt unless told otherwise, or null if there isn't the
+memory for one */
+RCPS_API rcps_context *rcps_context_new(int num_threads);
+RCPS_API void rcps_context_free(rcps_context *context);
+
+// the state plans start from when rcps_simulate_batch isn't given any
+RCPS_API void rcps_context_set_state(rcps_context *context,
+                                     const rcps_state *state);
+
+// forgets every length the context has seen
+RCPS_API void rcps_context_clear(rcps_context *context);
+
+RCPS_API void rcps_default_state(rcps_state *state);
+
+/* reads a STROOP TtcState file, returning 0 or -1 if it couldn't, with the
+reason printed */
+RCPS_API int rcps_load_state(const char *path, rcps_state *state);
+
+RCPS_API unsigned short rcps_state_rng(const rcps_state *state);
+RCPS_API void rcps_state_set_rng(rcps_state *state, unsigned short rng);
+
+/* Plays plans[i] from states[i], or from the context's state for all of them
+if states is null, and puts how long the cog then stays still in
+out_lengths[i], 1200 if it stays still the whole time. A plan longer than the
+simulator can hold gets -1. Returns how many plans got -1, or -1 if it ran out
+of memory, with only some of out_lengths filled in. */
+RCPS_API int rcps_simulate_batch(rcps_context *context,
+                                 const rcps_state *states,
+                                 const rcps_plan *plans, size_t count,
+                                 int *out_lengths);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif